@@ -34,6 +34,10 @@ common:
 	# any special flag that should be passed to the compiler when using this
 	# addon
 	# ADDON_CFLAGS =
+	# memory statistics (see ofxJsonDocument::getMemoryStats()). this changes the layout
+	# of rapidjson's classes, so it has to be set here (or in the project's defines)
+	# and not in a single source file.
+	# ADDON_CFLAGS += -DOFX_JSON_STATS
 	
 	# any special flag that should be passed to the linker when using this
 	# addon, also used for system libraries with -lname
@@ -79,6 +79,24 @@ public:
     static void Free(void *ptr) { std::free(ptr); }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// ChunkAllocator
+
+//! Interface for allocating the chunks of a MemoryPoolAllocator at runtime.
+/*! The BaseAllocator of MemoryPoolAllocator is a template parameter, so it can't be changed
+    without changing the type of the allocator (and of every value using it).
+    An implementation of this interface can be set with MemoryPoolAllocator::SetChunkAllocator() instead.
+*/
+class ChunkAllocator {
+public:
+    virtual ~ChunkAllocator() {}
+
+    //! Allocates a chunk of \c size bytes. Returns NULL on failure.
+    virtual void* Malloc(size_t size) = 0;
+    //! Frees a chunk allocated by Malloc(). \c size is the size passed to Malloc().
+    virtual void Free(void* ptr, size_t size) = 0;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // MemoryPoolAllocator
 
@@ -108,7 +126,10 @@ public:
         \param baseAllocator The allocator for allocating memory chunks.
     */
     MemoryPoolAllocator(size_t chunkSize = kDefaultChunkCapacity, BaseAllocator* baseAllocator = 0) : 
-        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(0), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
+        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(0), baseAllocator_(baseAllocator), ownBaseAllocator_(0), chunkAllocator_(0), freeChunks_(0)
+#if RAPIDJSON_STATS
+        , stats_()
+#endif
     {
     }
 
@@ -123,7 +144,10 @@ public:
         \param baseAllocator The allocator for allocating memory chunks.
     */
     MemoryPoolAllocator(void *buffer, size_t size, size_t chunkSize = kDefaultChunkCapacity, BaseAllocator* baseAllocator = 0) :
-        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(buffer), baseAllocator_(baseAllocator), ownBaseAllocator_(0)
+        chunkHead_(0), chunk_capacity_(chunkSize), userBuffer_(buffer), baseAllocator_(baseAllocator), ownBaseAllocator_(0), chunkAllocator_(0), freeChunks_(0)
+#if RAPIDJSON_STATS
+        , stats_()
+#endif
     {
         RAPIDJSON_ASSERT(buffer != 0);
         RAPIDJSON_ASSERT(size > sizeof(ChunkHeader));
@@ -145,15 +169,84 @@ public:
     void Clear() {
         while (chunkHead_ && chunkHead_ != userBuffer_) {
             ChunkHeader* next = chunkHead_->next;
-            baseAllocator_->Free(chunkHead_);
+            FreeChunk(chunkHead_);
             chunkHead_ = next;
         }
         if (chunkHead_ && chunkHead_ == userBuffer_)
             chunkHead_->size = 0; // Clear user buffer
+        ResetCurrentStats();
+        while (freeChunks_) {
+            ChunkHeader* next = freeChunks_->next;
+            FreeChunk(freeChunks_);
+            freeChunks_ = next;
+        }
+    }
+
+    //! Makes all memory available again without deallocating the chunks.
+    /*! Like Clear(), all memory blocks become invalid, but the chunks are kept for reuse
+        by the following allocations (until Clear() or destruction).
+    */
+    void Recycle() {
+        while (chunkHead_ && chunkHead_ != userBuffer_) {
+            ChunkHeader* next = chunkHead_->next;
+            chunkHead_->size = 0;
+            chunkHead_->next = freeChunks_;
+            freeChunks_ = chunkHead_;
+            chunkHead_ = next;
+        }
+        if (chunkHead_ && chunkHead_ == userBuffer_)
+            chunkHead_->size = 0; // Clear user buffer
+        ResetCurrentStats();
+    }
+
+#if RAPIDJSON_STATS
+    //! Memory statistics (only with RAPIDJSON_STATS).
+    /*! \c requested, \c wasted and \c size describe the current contents and are reset by Clear() and Recycle().
+    */
+    struct Stats {
+        size_t requested;   //!< Bytes asked for by Malloc() and by growing Realloc() calls.
+        size_t wasted;      //!< Alignment padding, unused rest of full chunks and blocks left behind by Realloc().
+        size_t size;        //!< Bytes handed out (same as Size(), without walking the chunks).
+        size_t peak;        //!< Maximum of \c size since construction or ResetPeak().
+    };
+
+    const Stats& GetStats() const { return stats_; }
+    void ResetPeak() { stats_.peak = stats_.size; }
+#endif
+
+    //! Number of chunks in use (including the user buffer).
+    size_t ChunkCount() const {
+        size_t count = 0;
+        for (ChunkHeader* c = chunkHead_; c != 0; c = c->next)
+            ++count;
+        return count;
+    }
+
+    //! Number and total capacity of the chunks kept by Recycle().
+    size_t RecycledChunkCount(size_t* capacity = 0) const {
+        size_t count = 0, total = 0;
+        for (ChunkHeader* c = freeChunks_; c != 0; c = c->next) {
+            ++count;
+            total += c->capacity;
+        }
+        if (capacity)
+            *capacity = total;
+        return count;
     }
 
+    //! Allocates further chunks with \c chunkAllocator instead of the BaseAllocator.
+    /*! Must be called before the first chunk is allocated. \c chunkAllocator must outlive this allocator.
+        Pass 0 to use the BaseAllocator again.
+    */
+    void SetChunkAllocator(ChunkAllocator* chunkAllocator) {
+        RAPIDJSON_ASSERT((chunkHead_ == 0 || chunkHead_ == userBuffer_) && freeChunks_ == 0);
+        chunkAllocator_ = chunkAllocator;
+    }
+
+    ChunkAllocator* GetChunkAllocator() const { return chunkAllocator_; }
+
     //! Computes the total capacity of allocated memory chunks.
-    /*! \return total capacity in bytes.
+    /*! \return total capacity in bytes (excluding the chunks kept by Recycle()).
     */
     size_t Capacity() const {
         size_t capacity = 0;
@@ -177,13 +270,26 @@ public:
         if (!size)
             return NULL;
 
+#if RAPIDJSON_STATS
+        const size_t requested = size;
+#endif
         size = RAPIDJSON_ALIGN(size);
-        if (chunkHead_ == 0 || chunkHead_->size + size > chunkHead_->capacity)
+        if (chunkHead_ == 0 || chunkHead_->size + size > chunkHead_->capacity) {
+#if RAPIDJSON_STATS
+            if (chunkHead_)
+                stats_.wasted += chunkHead_->capacity - chunkHead_->size; // never used again
+#endif
             if (!AddChunk(chunk_capacity_ > size ? chunk_capacity_ : size))
                 return NULL;
+        }
 
         void *buffer = reinterpret_cast<char *>(chunkHead_) + RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + chunkHead_->size;
         chunkHead_->size += size;
+#if RAPIDJSON_STATS
+        stats_.requested += requested;
+        stats_.wasted += size - requested;
+        AddSize(size);
+#endif
         return buffer;
     }
 
@@ -207,11 +313,18 @@ public:
             size_t increment = static_cast<size_t>(newSize - originalSize);
             if (chunkHead_->size + increment <= chunkHead_->capacity) {
                 chunkHead_->size += increment;
+#if RAPIDJSON_STATS
+                stats_.requested += increment;
+                AddSize(increment);
+#endif
                 return originalPtr;
             }
         }
 
         // Realloc process: allocate and copy memory, do not free original buffer.
+#if RAPIDJSON_STATS
+        stats_.wasted += originalSize;
+#endif
         if (void* newBuffer = Malloc(newSize)) {
             if (originalSize)
                 std::memcpy(newBuffer, originalPtr, originalSize);
@@ -235,9 +348,25 @@ private:
         \return true if success.
     */
     bool AddChunk(size_t capacity) {
-        if (!baseAllocator_)
-            ownBaseAllocator_ = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator());
-        if (ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(baseAllocator_->Malloc(RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + capacity))) {
+        // reuse a recycled chunk if one is big enough
+        for (ChunkHeader** c = &freeChunks_; *c != 0; c = &(*c)->next) {
+            if ((*c)->capacity >= capacity) {
+                ChunkHeader* chunk = *c;
+                *c = chunk->next;
+                chunk->next = chunkHead_;
+                chunkHead_ = chunk;
+                return true;
+            }
+        }
+        void* memory;
+        if (chunkAllocator_)
+            memory = chunkAllocator_->Malloc(RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + capacity);
+        else {
+            if (!baseAllocator_)
+                ownBaseAllocator_ = baseAllocator_ = RAPIDJSON_NEW(BaseAllocator());
+            memory = baseAllocator_->Malloc(RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + capacity);
+        }
+        if (ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(memory)) {
             chunk->capacity = capacity;
             chunk->size = 0;
             chunk->next = chunkHead_;
@@ -259,11 +388,38 @@ private:
         ChunkHeader *next;  //!< Next chunk in the linked list.
     };
 
+    void ResetCurrentStats() {
+#if RAPIDJSON_STATS
+        stats_.requested = stats_.wasted = stats_.size = 0;
+#endif
+    }
+
+#if RAPIDJSON_STATS
+    void AddSize(size_t size) {
+        stats_.size += size;
+        if (stats_.size > stats_.peak)
+            stats_.peak = stats_.size;
+    }
+#endif
+
+    //! Deallocates a chunk with the allocator which allocated it.
+    void FreeChunk(ChunkHeader* chunk) {
+        if (chunkAllocator_)
+            chunkAllocator_->Free(chunk, RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + chunk->capacity);
+        else
+            baseAllocator_->Free(chunk);
+    }
+
     ChunkHeader *chunkHead_;    //!< Head of the chunk linked-list. Only the head chunk serves allocation.
     size_t chunk_capacity_;     //!< The minimum capacity of chunk when they are allocated.
     void *userBuffer_;          //!< User supplied buffer.
     BaseAllocator* baseAllocator_;  //!< base allocator for allocating memory chunks.
     BaseAllocator* ownBaseAllocator_;   //!< base allocator created by this object.
+    ChunkAllocator* chunkAllocator_;    //!< replaces the base allocator if set.
+    ChunkHeader *freeChunks_;   //!< Chunks kept by Recycle().
+#if RAPIDJSON_STATS
+    Stats stats_;
+#endif
 };
 
 RAPIDJSON_NAMESPACE_END
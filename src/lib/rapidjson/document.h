@@ -410,6 +410,29 @@ template <typename T> struct IsGenericValue : IsGenericValueImpl<T>::Type {};
 
 } // namespace internal
 
+///////////////////////////////////////////////////////////////////////////////
+// HandleFloat
+
+namespace internal {
+
+// detects handlers which implement "bool Float(float)"
+template <typename Handler>
+struct HasFloatHandler {
+    template <typename U, bool (U::*)(float)> struct Check {};
+    template <typename U> static char Test(Check<U, &U::Float>*);
+    template <typename U> static int Test(...);
+    enum { Value = sizeof(Test<Handler>(0)) == sizeof(char) };
+};
+
+// values stored as float go to Float() if the handler has it (e.g. Writer), otherwise to Double()
+template <typename Handler>
+inline bool HandleFloat(Handler& handler, float f, TrueType) { return handler.Float(f); }
+
+template <typename Handler>
+inline bool HandleFloat(Handler& handler, float f, FalseType) { return handler.Double(static_cast<double>(f)); }
+
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////
 // TypeHelper
 
@@ -720,7 +743,10 @@ public:
     explicit GenericValue(double d) RAPIDJSON_NOEXCEPT : data_() { data_.n.d = d; data_.f.flags = kNumberDoubleFlag; }
 
     //! Constructor for float value.
-    explicit GenericValue(float f) RAPIDJSON_NOEXCEPT : data_() { data_.n.d = static_cast<double>(f); data_.f.flags = kNumberDoubleFlag; }
+    /*! The value is marked as single precision, so handlers with a \c Float() function
+        (e.g. Writer) get the float back in Accept() and can write its shortest representation.
+    */
+    explicit GenericValue(float f) RAPIDJSON_NOEXCEPT : data_() { data_.n.d = static_cast<double>(f); data_.f.flags = kNumberFloatFlag; }
 
     //! Constructor for constant string (i.e. do not make a copy of string)
     GenericValue(const Ch* s, SizeType length) RAPIDJSON_NOEXCEPT : data_() { SetStringRaw(StringRef(s, length)); }
@@ -996,6 +1022,8 @@ public:
     bool IsInt64()  const { return (data_.f.flags & kInt64Flag) != 0; }
     bool IsUint64() const { return (data_.f.flags & kUint64Flag) != 0; }
     bool IsDouble() const { return (data_.f.flags & kDoubleFlag) != 0; }
+    //! Whether the number was stored as float (see GenericValue(float) and SetFloat()).
+    bool IsStoredAsFloat() const { return (data_.f.flags & kFloatFlag) != 0; }
     bool IsString() const { return (data_.f.flags & kStringFlag) != 0; }
 
     // Checks whether a number can be losslessly converted to a double.
@@ -1721,7 +1749,7 @@ public:
     GenericValue& SetInt64(int64_t i64)     { this->~GenericValue(); new (this) GenericValue(i64);  return *this; }
     GenericValue& SetUint64(uint64_t u64)   { this->~GenericValue(); new (this) GenericValue(u64);  return *this; }
     GenericValue& SetDouble(double d)       { this->~GenericValue(); new (this) GenericValue(d);    return *this; }
-    GenericValue& SetFloat(float f)         { this->~GenericValue(); new (this) GenericValue(static_cast<double>(f)); return *this; }
+    GenericValue& SetFloat(float f)         { this->~GenericValue(); new (this) GenericValue(f);    return *this; }
 
     //@}
 
@@ -1846,7 +1874,8 @@ public:
     
         default:
             RAPIDJSON_ASSERT(GetType() == kNumberType);
-            if (IsDouble())         return handler.Double(data_.n.d);
+            if (IsStoredAsFloat())  return internal::HandleFloat(handler, static_cast<float>(data_.n.d), internal::BoolType<internal::HasFloatHandler<Handler>::Value>());
+            else if (IsDouble())    return handler.Double(data_.n.d);
             else if (IsInt())       return handler.Int(data_.n.i.i);
             else if (IsUint())      return handler.Uint(data_.n.u.u);
             else if (IsInt64())     return handler.Int64(data_.n.i64);
@@ -1854,6 +1883,13 @@ public:
         }
     }
 
+    //! Estimates the memory this value and its children occupy.
+    /*! Counts the value itself, the capacity of arrays and objects and copied strings.
+        Short strings, strings referenced with StringRef() and strings parsed in-situ only cost the value.
+        Memory left behind by reallocations isn't included.
+    */
+    size_t GetFootprint() const { return sizeof(GenericValue) + GetChildrenFootprint(); }
+
 private:
     template <typename, typename> friend class GenericValue;
     template <typename, typename, typename> friend class GenericDocument;
@@ -1869,6 +1905,7 @@ private:
         kStringFlag     = 0x0400,
         kCopyFlag       = 0x0800,
         kInlineStrFlag  = 0x1000,
+        kFloatFlag      = 0x2000,
 
         // Initial flags of different types.
         kNullFlag = kNullType,
@@ -1879,6 +1916,7 @@ private:
         kNumberInt64Flag = kNumberType | kNumberFlag | kInt64Flag,
         kNumberUint64Flag = kNumberType | kNumberFlag | kUint64Flag,
         kNumberDoubleFlag = kNumberType | kNumberFlag | kDoubleFlag,
+        kNumberFloatFlag = kNumberDoubleFlag | kFloatFlag,
         kNumberAnyFlag = kNumberType | kNumberFlag | kIntFlag | kInt64Flag | kUintFlag | kUint64Flag | kDoubleFlag,
         kConstStringFlag = kStringType | kStringFlag,
         kCopyStringFlag = kStringType | kStringFlag | kCopyFlag,
@@ -1892,6 +1930,29 @@ private:
     static const SizeType kDefaultArrayCapacity = 16;
     static const SizeType kDefaultObjectCapacity = 16;
 
+    size_t GetChildrenFootprint() const {
+        size_t size = 0;
+        switch (data_.f.flags & kTypeMask) {
+        case kObjectType:
+            size = RAPIDJSON_ALIGN(data_.o.capacity * sizeof(Member));
+            for (ConstMemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
+                size += m->name.GetChildrenFootprint() + m->value.GetChildrenFootprint();
+            break;
+        case kArrayType:
+            size = RAPIDJSON_ALIGN(data_.a.capacity * sizeof(GenericValue));
+            for (const GenericValue* v = Begin(); v != End(); ++v)
+                size += v->GetChildrenFootprint();
+            break;
+        case kStringType:
+            if (data_.f.flags == kCopyStringFlag)
+                size = RAPIDJSON_ALIGN((data_.s.length + 1) * sizeof(Ch));
+            break;
+        default:
+            break;
+        }
+        return size;
+    }
+
     struct Flag {
 #if RAPIDJSON_48BITPOINTER_OPTIMIZATION
         char payload[sizeof(SizeType) * 2 + 6];     // 2 x SizeType + lower 48-bit pointer
@@ -2085,7 +2146,7 @@ public:
         \param stackAllocator   Optional allocator for allocating memory for stack.
     */
     explicit GenericDocument(Type type, Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity, StackAllocator* stackAllocator = 0) :
-        GenericValue<Encoding, Allocator>(type),  allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_()
+        GenericValue<Encoding, Allocator>(type),  allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_(), readerStack_(stackAllocator, kDefaultReaderStackCapacity), keepStack_(false)
     {
         if (!allocator_)
             ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator());
@@ -2098,7 +2159,7 @@ public:
         \param stackAllocator   Optional allocator for allocating memory for stack.
     */
     GenericDocument(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity, StackAllocator* stackAllocator = 0) : 
-        allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_()
+        allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_(), readerStack_(stackAllocator, kDefaultReaderStackCapacity), keepStack_(false)
     {
         if (!allocator_)
             ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator());
@@ -2111,7 +2172,9 @@ public:
           allocator_(rhs.allocator_),
           ownAllocator_(rhs.ownAllocator_),
           stack_(std::move(rhs.stack_)),
-          parseResult_(rhs.parseResult_)
+          parseResult_(rhs.parseResult_),
+          readerStack_(std::move(rhs.readerStack_)),
+          keepStack_(rhs.keepStack_)
     {
         rhs.allocator_ = 0;
         rhs.ownAllocator_ = 0;
@@ -2138,6 +2201,8 @@ public:
         ownAllocator_ = rhs.ownAllocator_;
         stack_ = std::move(rhs.stack_);
         parseResult_ = rhs.parseResult_;
+        readerStack_ = std::move(rhs.readerStack_);
+        keepStack_ = rhs.keepStack_;
 
         rhs.allocator_ = 0;
         rhs.ownAllocator_ = 0;
@@ -2147,6 +2212,23 @@ public:
     }
 #endif
 
+    //! Use caller owned buffers for the parse stacks until they are full (see internal::Stack::SetUserBuffer()).
+    /*! \c buffer holds the values under construction, \c readerBuffer the strings being decoded by the reader.
+        Together with a MemoryPoolAllocator on a user buffer, small documents can be parsed without any heap allocation.
+        \note Must be called before the first parse.
+    */
+    void SetStackBuffer(void* buffer, size_t size, void* readerBuffer = 0, size_t readerBufferSize = 0) {
+        stack_.SetUserBuffer(buffer, size);
+        if (readerBuffer)
+            readerStack_.SetUserBuffer(readerBuffer, readerBufferSize);
+    }
+
+    //! Keep the memory of the parse stacks after parsing instead of deallocating it.
+    /*! Useful when the same document parses many messages: the stacks then only grow
+        to the size the biggest message needs and are never reallocated after that.
+    */
+    void KeepStackCapacity(bool keep) { keepStack_ = keep; }
+
     //! Exchange the contents of this document with those of another.
     /*!
         \param rhs Another document.
@@ -2159,6 +2241,8 @@ public:
         internal::Swap(allocator_, rhs.allocator_);
         internal::Swap(ownAllocator_, rhs.ownAllocator_);
         internal::Swap(parseResult_, rhs.parseResult_);
+        readerStack_.Swap(rhs.readerStack_);
+        internal::Swap(keepStack_, rhs.keepStack_);
         return *this;
     }
 
@@ -2205,8 +2289,10 @@ public:
     GenericDocument& ParseStream(InputStream& is) {
         GenericReader<SourceEncoding, Encoding, StackAllocator> reader(
             stack_.HasAllocator() ? &stack_.GetAllocator() : 0);
+        reader.SwapStack(readerStack_); // the reader borrows the stack of the document, see ClearStack()
         ClearStackOnExit scope(*this);
         parseResult_ = reader.template Parse<parseFlags>(is, *this);
+        reader.SwapStack(readerStack_);
         if (parseResult_) {
             RAPIDJSON_ASSERT(stack_.GetSize() == sizeof(ValueType)); // Got one and only one root object
             ValueType::operator=(*stack_.template Pop<ValueType>(1));// Move value from stack to document
@@ -2360,9 +2446,26 @@ public:
         return *allocator_;
     }
 
+    //! Get the allocator of this document (e.g. for its statistics).
+    const Allocator& GetAllocator() const {
+        RAPIDJSON_ASSERT(allocator_);
+        return *allocator_;
+    }
+
     //! Get the capacity of stack in bytes.
     size_t GetStackCapacity() const { return stack_.GetCapacity(); }
 
+#if RAPIDJSON_STATS
+    //! Maximum size of the stack for values under construction (only with RAPIDJSON_STATS).
+    size_t GetStackHighWater() const { return stack_.GetHighWater(); }
+    //! Maximum size of the stack for decoding strings (only with RAPIDJSON_STATS).
+    size_t GetReaderStackHighWater() const { return readerStack_.GetHighWater(); }
+    void ResetStackHighWater() {
+        stack_.ResetHighWater();
+        readerStack_.ResetHighWater();
+    }
+#endif
+
 private:
     // clear stack on any exit from ParseStream, e.g. due to exception
     struct ClearStackOnExit {
@@ -2387,6 +2490,7 @@ public:
     bool Int64(int64_t i) { new (stack_.template Push<ValueType>()) ValueType(i); return true; }
     bool Uint64(uint64_t i) { new (stack_.template Push<ValueType>()) ValueType(i); return true; }
     bool Double(double d) { new (stack_.template Push<ValueType>()) ValueType(d); return true; }
+    bool Float(float f) { new (stack_.template Push<ValueType>()) ValueType(f); return true; }
 
     bool RawNumber(const Ch* str, SizeType length, bool copy) { 
         if (copy) 
@@ -2434,7 +2538,10 @@ private:
                 (stack_.template Pop<ValueType>(1))->~ValueType();
         else
             stack_.Clear();
-        stack_.ShrinkToFit();
+        if (!keepStack_) {
+            stack_.ShrinkToFit();
+            readerStack_.ShrinkToFit();
+        }
     }
 
     void Destroy() {
@@ -2442,10 +2549,13 @@ private:
     }
 
     static const size_t kDefaultStackCapacity = 1024;
+    static const size_t kDefaultReaderStackCapacity = 256;
     Allocator* allocator_;
     Allocator* ownAllocator_;
     internal::Stack<StackAllocator> stack_;
     ParseResult parseResult_;
+    internal::Stack<StackAllocator> readerStack_; //!< decodes strings (lent to the reader)
+    bool keepStack_;
 };
 
 //! GenericDocument with UTF8 encoding
@@ -60,6 +60,23 @@ public:
         }
     }
 
+    void Write(const char* s, size_t n) {
+        size_t avail = static_cast<size_t>(bufferEnd_ - current_);
+        while (n > avail) {
+            std::memcpy(current_, s, avail);
+            current_ += avail;
+            Flush();
+            s += avail;
+            n -= avail;
+            avail = static_cast<size_t>(bufferEnd_ - current_);
+        }
+
+        if (n > 0) {
+            std::memcpy(current_, s, n);
+            current_ += n;
+        }
+    }
+
     void Flush() {
         if (current_ != buffer_) {
             size_t result = fwrite(buffer_, 1, static_cast<size_t>(current_ - buffer_), fp_);
@@ -95,6 +112,11 @@ inline void PutN(FileWriteStream& stream, char c, size_t n) {
     stream.PutN(c, n);
 }
 
+//! Implement specialized version of PutUnsafe() with memcpy() for runs of characters.
+inline void PutUnsafe(FileWriteStream& stream, const char* s, size_t n) {
+    stream.Write(s, n);
+}
+
 RAPIDJSON_NAMESPACE_END
 
 #ifdef __clang__
@@ -123,6 +123,39 @@ inline void Grisu2(double value, char* buffer, int* length, int* K) {
     DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
 }
 
+// Grisu2 for single precision: the boundaries are those of the float, so the generated
+// digits are the shortest ones which still read back as the same float (not as the same double).
+inline void Grisu2(float value, char* buffer, int* length, int* K) {
+    uint32_t u;
+    std::memcpy(&u, &value, sizeof(u));
+    const int biased_e = static_cast<int>((u & 0x7F800000u) >> 23);
+    const uint64_t significand = u & 0x007FFFFFu;
+    uint64_t f;
+    int e;
+    if (biased_e != 0) {
+        f = significand + 0x00800000u;
+        e = biased_e - 150;
+    }
+    else {
+        f = significand;
+        e = -149;
+    }
+
+    const DiyFp v(f, e);
+    const DiyFp w_p = DiyFp((f << 1) + 1, e - 1).Normalize();
+    DiyFp w_m = (f == 0x00800000u && biased_e > 1) ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+    w_m.f <<= w_m.e - w_p.e;
+    w_m.e = w_p.e;
+
+    const DiyFp c_mk = GetCachedPower(w_p.e, K);
+    const DiyFp W = v.Normalize() * c_mk;
+    DiyFp Wp = w_p * c_mk;
+    DiyFp Wm = w_m * c_mk;
+    Wm.f++;
+    Wp.f--;
+    DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+}
+
 inline char* WriteExponent(int K, char* buffer) {
     if (K < 0) {
         *buffer++ = '-';
@@ -235,6 +268,30 @@ inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
     }
 }
 
+//! Shortest round-trip formatting of a float (at most 9 significant digits), e.g. 0.1f -> "0.1".
+inline char* ftoa(float value, char* buffer, int maxDecimalPlaces = 324) {
+    RAPIDJSON_ASSERT(maxDecimalPlaces >= 1);
+    uint32_t u;
+    std::memcpy(&u, &value, sizeof(u));
+    if ((u & 0x7FFFFFFFu) == 0) {
+        if (u & 0x80000000u)
+            *buffer++ = '-';     // -0.0
+        buffer[0] = '0';
+        buffer[1] = '.';
+        buffer[2] = '0';
+        return &buffer[3];
+    }
+    else {
+        if (value < 0) {
+            *buffer++ = '-';
+            value = -value;
+        }
+        int length, K;
+        Grisu2(value, buffer, &length, &K);
+        return Prettify(buffer, length, K, maxDecimalPlaces);
+    }
+}
+
 #ifdef __GNUC__
 RAPIDJSON_DIAG_POP
 #endif
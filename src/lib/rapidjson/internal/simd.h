@@ -0,0 +1,136 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+// 
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed 
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_INTERNAL_SIMD_H_
+#define RAPIDJSON_INTERNAL_SIMD_H_
+
+#include "../rapidjson.h"
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#include <atomic>
+#define RAPIDJSON_SIMD_LEVEL_ATOMIC
+#endif
+
+//! Compile a function for a specific instruction set (only needed with RAPIDJSON_SIMD_DISPATCH)
+#if defined(RAPIDJSON_SIMD_DISPATCH) && defined(__GNUC__)
+#define RAPIDJSON_TARGET(x) __attribute__((target(x)))
+#else
+#define RAPIDJSON_TARGET(x)
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+namespace internal {
+
+///////////////////////////////////////////////////////////////////////////////
+// SimdLevel
+
+//! Instruction sets of the SIMD code paths, in ascending order.
+enum SimdLevel {
+    kSimdScalar = 0,
+    kSimdSSE2,
+    kSimdSSE42,
+    kSimdAVX2
+};
+
+//! Best level supported by the CPU (with RAPIDJSON_SIMD_DISPATCH) or selected at compile time.
+inline SimdLevel DetectSimdLevel() {
+#if defined(RAPIDJSON_SIMD_DISPATCH) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool sse42 = (info[2] & (1 << 20)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) { // the OS saves the YMM registers
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? kSimdAVX2 : sse42 ? kSimdSSE42 : sse2 ? kSimdSSE2 : kSimdScalar;
+#elif defined(RAPIDJSON_SIMD_DISPATCH)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? kSimdAVX2 :
+        __builtin_cpu_supports("sse4.2") ? kSimdSSE42 :
+        __builtin_cpu_supports("sse2") ? kSimdSSE2 : kSimdScalar;
+#elif defined(RAPIDJSON_SSE42)
+    return kSimdSSE42;
+#elif defined(RAPIDJSON_SSE2)
+    return kSimdSSE2;
+#else
+    return kSimdScalar;
+#endif
+}
+
+//! Best level supported by the CPU (detected once).
+inline SimdLevel GetSupportedSimdLevel() {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+// relaxed atomic, so that the level can be changed while other threads are parsing
+#ifdef RAPIDJSON_SIMD_LEVEL_ATOMIC
+inline std::atomic<int>& SimdLevelStorage() {
+    static std::atomic<int> level(GetSupportedSimdLevel());
+    return level;
+}
+
+//! Level of the code paths currently in use.
+inline SimdLevel GetSimdLevel() {
+    return static_cast<SimdLevel>(SimdLevelStorage().load(std::memory_order_relaxed));
+}
+#else
+inline SimdLevel& SimdLevelStorage() {
+    static SimdLevel level = GetSupportedSimdLevel();
+    return level;
+}
+
+//! Level of the code paths currently in use.
+inline SimdLevel GetSimdLevel() {
+    return SimdLevelStorage();
+}
+#endif
+
+//! Force a lower level, e.g. to compare the code paths in tests and benchmarks.
+/*! Only possible with RAPIDJSON_SIMD_DISPATCH. Thread-safe with C++11 (every scan picks up
+    the new level, a running parse may mix both); before C++11 call it before parsing or writing.
+    \return false if the level isn't supported.
+*/
+inline bool SetSimdLevel(SimdLevel level) {
+#ifdef RAPIDJSON_SIMD_DISPATCH
+    if (level > GetSupportedSimdLevel())
+        return false;
+#ifdef RAPIDJSON_SIMD_LEVEL_ATOMIC
+    SimdLevelStorage().store(level, std::memory_order_relaxed);
+#else
+    SimdLevelStorage() = level;
+#endif
+    return true;
+#else
+    return level == GetSupportedSimdLevel();
+#endif
+}
+
+} // namespace internal
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_INTERNAL_SIMD_H_
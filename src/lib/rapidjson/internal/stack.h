@@ -37,7 +37,11 @@ class Stack {
 public:
     // Optimization note: Do not allocate memory for stack_ in constructor.
     // Do it lazily when first Push() -> Expand() -> Resize().
-    Stack(Allocator* allocator, size_t stackCapacity) : allocator_(allocator), ownAllocator_(0), stack_(0), stackTop_(0), stackEnd_(0), initialCapacity_(stackCapacity) {
+    Stack(Allocator* allocator, size_t stackCapacity) : allocator_(allocator), ownAllocator_(0), stack_(0), stackTop_(0), stackEnd_(0), initialCapacity_(stackCapacity), userBuffer_(0), userBufferEnd_(0)
+#if RAPIDJSON_STATS
+        , highWater_(0)
+#endif
+    {
     }
 
 #if RAPIDJSON_HAS_CXX11_RVALUE_REFS
@@ -47,7 +51,12 @@ public:
           stack_(rhs.stack_),
           stackTop_(rhs.stackTop_),
           stackEnd_(rhs.stackEnd_),
-          initialCapacity_(rhs.initialCapacity_)
+          initialCapacity_(rhs.initialCapacity_),
+          userBuffer_(rhs.userBuffer_),
+          userBufferEnd_(rhs.userBufferEnd_)
+#if RAPIDJSON_STATS
+          , highWater_(rhs.highWater_)
+#endif
     {
         rhs.allocator_ = 0;
         rhs.ownAllocator_ = 0;
@@ -55,6 +64,8 @@ public:
         rhs.stackTop_ = 0;
         rhs.stackEnd_ = 0;
         rhs.initialCapacity_ = 0;
+        rhs.userBuffer_ = 0;
+        rhs.userBufferEnd_ = 0;
     }
 #endif
 
@@ -74,6 +85,11 @@ public:
             stackTop_ = rhs.stackTop_;
             stackEnd_ = rhs.stackEnd_;
             initialCapacity_ = rhs.initialCapacity_;
+            userBuffer_ = rhs.userBuffer_;
+            userBufferEnd_ = rhs.userBufferEnd_;
+#if RAPIDJSON_STATS
+            highWater_ = rhs.highWater_;
+#endif
 
             rhs.allocator_ = 0;
             rhs.ownAllocator_ = 0;
@@ -81,6 +97,8 @@ public:
             rhs.stackTop_ = 0;
             rhs.stackEnd_ = 0;
             rhs.initialCapacity_ = 0;
+            rhs.userBuffer_ = 0;
+            rhs.userBufferEnd_ = 0;
         }
         return *this;
     }
@@ -93,17 +111,33 @@ public:
         internal::Swap(stackTop_, rhs.stackTop_);
         internal::Swap(stackEnd_, rhs.stackEnd_);
         internal::Swap(initialCapacity_, rhs.initialCapacity_);
+        internal::Swap(userBuffer_, rhs.userBuffer_);
+        internal::Swap(userBufferEnd_, rhs.userBufferEnd_);
+#if RAPIDJSON_STATS
+        internal::Swap(highWater_, rhs.highWater_);
+#endif
+    }
+
+    //! Use a caller owned buffer for the stack until it is full.
+    /*! Then the stack moves to memory from the allocator. The buffer is not deallocated by the stack.
+        Must be called before anything is pushed.
+    */
+    void SetUserBuffer(void* buffer, size_t size) {
+        RAPIDJSON_ASSERT(stack_ == 0);
+        userBuffer_ = stack_ = stackTop_ = static_cast<char*>(buffer);
+        userBufferEnd_ = stackEnd_ = stack_ + size;
     }
 
     void Clear() { stackTop_ = stack_; }
 
     void ShrinkToFit() { 
+        if (stack_ == userBuffer_)
+            return; // nothing to give back
         if (Empty()) {
             // If the stack is empty, completely deallocate the memory.
             Allocator::Free(stack_);
-            stack_ = 0;
-            stackTop_ = 0;
-            stackEnd_ = 0;
+            stack_ = stackTop_ = userBuffer_; // back to the user buffer, if any
+            stackEnd_ = userBufferEnd_;
         }
         else
             Resize(GetSize());
@@ -129,6 +163,10 @@ public:
         RAPIDJSON_ASSERT(stackTop_ + sizeof(T) * count <= stackEnd_);
         T* ret = reinterpret_cast<T*>(stackTop_);
         stackTop_ += sizeof(T) * count;
+#if RAPIDJSON_STATS
+        if (GetSize() > highWater_)
+            highWater_ = GetSize();
+#endif
         return ret;
     }
 
@@ -176,6 +214,12 @@ public:
     size_t GetSize() const { return static_cast<size_t>(stackTop_ - stack_); }
     size_t GetCapacity() const { return static_cast<size_t>(stackEnd_ - stack_); }
 
+#if RAPIDJSON_STATS
+    //! Maximum size in bytes since construction or ResetHighWater().
+    size_t GetHighWater() const { return highWater_; }
+    void ResetHighWater() { highWater_ = GetSize(); }
+#endif
+
 private:
     template<typename T>
     void Expand(size_t count) {
@@ -198,13 +242,24 @@ private:
 
     void Resize(size_t newCapacity) {
         const size_t size = GetSize();  // Backup the current size
-        stack_ = static_cast<char*>(allocator_->Realloc(stack_, GetCapacity(), newCapacity));
+        if (stack_ != 0 && stack_ == userBuffer_) {
+            // move from the user buffer to the allocator
+            if (!allocator_)
+                ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator());
+            char* newStack = static_cast<char*>(allocator_->Malloc(newCapacity));
+            if (size)
+                std::memcpy(newStack, stack_, size);
+            stack_ = newStack;
+        }
+        else
+            stack_ = static_cast<char*>(allocator_->Realloc(stack_, GetCapacity(), newCapacity));
         stackTop_ = stack_ + size;
         stackEnd_ = stack_ + newCapacity;
     }
 
     void Destroy() {
-        Allocator::Free(stack_);
+        if (stack_ != userBuffer_)
+            Allocator::Free(stack_);
         RAPIDJSON_DELETE(ownAllocator_); // Only delete if it is owned by the stack
     }
 
@@ -218,6 +273,11 @@ private:
     char *stackTop_;
     char *stackEnd_;
     size_t initialCapacity_;
+    char *userBuffer_;   //!< caller owned memory (see SetUserBuffer())
+    char *userBufferEnd_;
+#if RAPIDJSON_STATS
+    size_t highWater_;
+#endif
 };
 
 } // namespace internal
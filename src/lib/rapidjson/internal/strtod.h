@@ -19,6 +19,14 @@
 #include "biginteger.h"
 #include "diyfp.h"
 #include "pow10.h"
+#include "pow5.h"
+#include <limits>
+
+#if defined(_MSC_VER) && defined(_M_AMD64)
+#include <intrin.h>
+#pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_umul128)
+#endif
 
 RAPIDJSON_NAMESPACE_BEGIN
 namespace internal {
@@ -125,6 +133,169 @@ inline bool StrtodFast(double d, int p, double* result) {
         return false;
 }
 
+//! Full 64x64 -> 128-bit multiplication, returns the low and stores the high 64 bits.
+inline uint64_t Mul128(uint64_t a, uint64_t b, uint64_t* high) {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+    return _umul128(a, b, high);
+#elif (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6)) && defined(__x86_64__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 p = static_cast<uint128>(a) * static_cast<uint128>(b);
+    *high = static_cast<uint64_t>(p >> 64);
+    return static_cast<uint64_t>(p);
+#else
+    const uint64_t M32 = 0xFFFFFFFF;
+    const uint64_t a0 = a & M32, a1 = a >> 32;
+    const uint64_t b0 = b & M32, b1 = b >> 32;
+    const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    const uint64_t mid = (p00 >> 32) + (p01 & M32) + (p10 & M32);
+    *high = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (p00 & M32);
+#endif
+}
+
+inline int CountLeadingZeros64(uint64_t x) {
+    RAPIDJSON_ASSERT(x != 0);
+#if defined(_MSC_VER) && defined(_M_AMD64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#elif defined(__GNUC__) && __GNUC__ >= 4
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & (uint64_t(1) << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+//! Load 8 characters as a little-endian 64-bit word for the SWAR digit functions.
+/*! The reader may load past the terminating zero of a string (but never across a page),
+    so this is excluded from AddressSanitizer instrumentation.
+*/
+RAPIDJSON_NO_SANITIZE_ADDRESS inline uint64_t LoadEightChars(const char* p) {
+    uint64_t v;
+#ifdef RAPIDJSON_ASAN
+    // byte by byte, because ASan intercepts memcpy() calls (e.g. at -O0)
+    v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+#else
+    std::memcpy(&v, p, sizeof(v));
+#if RAPIDJSON_ENDIAN == RAPIDJSON_BIGENDIAN
+    v = ((v & RAPIDJSON_UINT64_C2(0x00FF00FF, 0x00FF00FF)) << 8) | ((v >> 8) & RAPIDJSON_UINT64_C2(0x00FF00FF, 0x00FF00FF));
+    v = ((v & RAPIDJSON_UINT64_C2(0x0000FFFF, 0x0000FFFF)) << 16) | ((v >> 16) & RAPIDJSON_UINT64_C2(0x0000FFFF, 0x0000FFFF));
+    v = (v << 32) | (v >> 32);
+#endif
+#endif
+    return v;
+}
+
+//! Check if all 8 characters of a word from LoadEightChars() are decimal digits.
+inline bool IsEightDigits(uint64_t v) {
+    return (((v & RAPIDJSON_UINT64_C2(0xF0F0F0F0, 0xF0F0F0F0)) |
+             (((v + RAPIDJSON_UINT64_C2(0x06060606, 0x06060606)) & RAPIDJSON_UINT64_C2(0xF0F0F0F0, 0xF0F0F0F0)) >> 4))
+            == RAPIDJSON_UINT64_C2(0x33333333, 0x33333333));
+}
+
+//! Convert 8 decimal digits from LoadEightChars() with three multiplications (SWAR).
+inline uint32_t ParseEightDigits(uint64_t v) {
+    const uint64_t mask = RAPIDJSON_UINT64_C2(0x000000FF, 0x000000FF);
+    const uint64_t mul1 = RAPIDJSON_UINT64_C2(0x000F4240, 0x00000064); // 100 + (1000000 << 32)
+    const uint64_t mul2 = RAPIDJSON_UINT64_C2(0x00002710, 0x00000001); // 1 + (10000 << 32)
+    v -= RAPIDJSON_UINT64_C2(0x30303030, 0x30303030);
+    v = (v * 10) + (v >> 8); // pairs of digits
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return static_cast<uint32_t>(v);
+}
+
+//! Convert w * 10^q to the nearest double with the Eisel-Lemire algorithm.
+/*! D. Lemire, "Number Parsing at a Gigabyte per Second", Software: Practice and
+    Experience 51(8), 2021. The significand is multiplied with a 128-bit
+    approximation of 5^q (Pow5_128()), which decides the rounding in all but
+    very rare cases.
+    \param w decimal significand
+    \param q decimal exponent
+    \param result the correctly rounded value (0 on underflow, infinity on overflow)
+    \return false if the approximation is not sufficient, the caller has to fall back then.
+*/
+inline bool StrtodEiselLemire(uint64_t w, int q, double* result) {
+    if (w == 0 || q < -342) {
+        *result = 0.0;
+        return true;
+    }
+    if (q > 308) {
+        *result = std::numeric_limits<double>::infinity();
+        return true;
+    }
+
+    const int lz = CountLeadingZeros64(w);
+    w <<= lz;
+
+    // Only the upper 54 bits of the product are needed, the second half of 5^q
+    // is only taken into account if the lower bits of the first product are all set.
+    const uint64_t* pow5 = Pow5_128(q);
+    uint64_t high;
+    uint64_t low = Mul128(w, pow5[0], &high);
+    if ((high & 0x1FF) == 0x1FF) {
+        uint64_t secondHigh;
+        Mul128(w, pow5[1], &secondHigh);
+        low += secondHigh;
+        if (secondHigh > low)
+            high++;
+    }
+    // 5^q is exact for q in [0, 55], and its reciprocal is precise enough for q in [-27, 0)
+    if (low == ~uint64_t(0) && (q < -27 || q > 55))
+        return false;
+
+    const int upperBit = static_cast<int>(high >> 63);
+    uint64_t mantissa = high >> (upperBit + 9);
+    // floor(log2(10^q)) + 63 for the binary exponent of the product, biased for IEEE 754
+    int power2 = (((152170 + 65536) * q) >> 16) + 63 + upperBit - lz + 1023;
+
+    if (power2 <= 0) { // subnormal
+        if (-power2 + 1 >= 64) {
+            *result = 0.0;
+            return true;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += (mantissa & 1); // round up, ties can't occur at this precision
+        mantissa >>= 1;
+        // rounding up may have produced the smallest normal number
+        power2 = (mantissa < (uint64_t(1) << 52)) ? 0 : 1;
+        *result = Double((static_cast<uint64_t>(power2) << 52) | (mantissa & ~(uint64_t(1) << 52))).Value();
+        return true;
+    }
+
+    // Exactly halfway between two doubles: only possible for small q, round to even
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << (upperBit + 9)) == high)
+        mantissa &= ~uint64_t(1);
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    if (mantissa >= (uint64_t(2) << 52)) {
+        mantissa = uint64_t(1) << 52;
+        power2++;
+    }
+    mantissa &= ~(uint64_t(1) << 52);
+
+    if (power2 >= 0x7FF)
+        *result = std::numeric_limits<double>::infinity();
+    else
+        *result = Double((static_cast<uint64_t>(power2) << 52) | mantissa).Value();
+    return true;
+}
+
+//! Convert a decimal with more than 19 digits, given the first 19 digits as \c w.
+/*! w * 10^q and (w + 1) * 10^q bracket the exact value, so their common rounding is the result.
+*/
+inline bool StrtodEiselLemireTruncated(uint64_t w, int q, double* result) {
+    double upper;
+    return StrtodEiselLemire(w, q, result) && StrtodEiselLemire(w + 1, q, &upper) && *result == upper;
+}
+
 // Compute an approximation and see if it is within 1/2 ULP
 inline bool StrtodDiyFp(const char* decimals, size_t length, size_t decimalPosition, int exp, double* result) {
     uint64_t significand = 0;
@@ -256,6 +427,17 @@ inline double StrtodFullPrecision(double d, int p, const char* decimals, size_t
     if (int(length) + exp < -324)
         return 0.0;
 
+    // Correctly rounded from the first 19 digits in almost all cases
+    {
+        const size_t n = length < 19 ? length : 19;
+        uint64_t w = 0;
+        for (size_t i = 0; i < n; i++)
+            w = w * 10u + static_cast<unsigned>(decimals[i] - '0');
+        const int q = static_cast<int>(decimalPosition) - static_cast<int>(n) + exp;
+        if (length <= 19 ? StrtodEiselLemire(w, q, &result) : StrtodEiselLemireTruncated(w, q, &result))
+            return result;
+    }
+
     if (StrtodDiyFp(decimals, length, decimalPosition, exp, &result))
         return result;
 
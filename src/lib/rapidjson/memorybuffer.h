@@ -59,6 +59,12 @@ struct GenericMemoryBuffer {
 
 typedef GenericMemoryBuffer<> MemoryBuffer;
 
+//! Implement specialized version of PutUnsafe() with memcpy() for runs of characters.
+template<typename Allocator>
+inline void PutUnsafe(GenericMemoryBuffer<Allocator>& memoryBuffer, const char* s, size_t n) {
+    std::memcpy(memoryBuffer.Push(n), s, n);
+}
+
 //! Implement specialized version of PutN() with memset() for better performance.
 template<>
 inline void PutN(MemoryBuffer& memoryBuffer, char c, size_t n) {
@@ -51,6 +51,10 @@ public:
         stream_.put(c);
     }
 
+    void Write(const Ch* s, size_t n) {
+        stream_.write(s, static_cast<std::streamsize>(n));
+    }
+
     void Flush() {
         stream_.flush();
     }
@@ -72,6 +76,12 @@ private:
 typedef BasicOStreamWrapper<std::ostream> OStreamWrapper;
 typedef BasicOStreamWrapper<std::wostream> WOStreamWrapper;
 
+//! Write runs of characters with a single write() call.
+template <typename StreamType>
+inline void PutUnsafe(BasicOStreamWrapper<StreamType>& stream, const typename StreamType::char_type* s, size_t n) {
+    stream.Write(s, n);
+}
+
 #ifdef __clang__
 RAPIDJSON_DIAG_POP
 #endif
@@ -346,11 +346,89 @@
     If any of these symbols is defined, RapidJSON defines the macro
     \c RAPIDJSON_SIMD to indicate the availability of the optimized code.
 */
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) \
+
+/*! \def RAPIDJSON_NO_SANITIZE_ADDRESS
+    \ingroup RAPIDJSON_CONFIG
+    \brief Exclude a function from AddressSanitizer instrumentation.
+
+    Some SIMD kernels load whole aligned blocks and may read past the end of
+    the (null-terminated) input. An aligned block never crosses a page boundary,
+    so this is safe, but AddressSanitizer reports it. When the code is compiled
+    with AddressSanitizer (\c RAPIDJSON_ASAN is defined), such kernels are marked
+    with this attribute; otherwise it expands to nothing.
+*/
+#if defined(__SANITIZE_ADDRESS__)
+#define RAPIDJSON_ASAN
+#elif defined(__clang__)
+#if __has_feature(address_sanitizer)
+#define RAPIDJSON_ASAN
+#endif
+#endif
+
+#if defined(RAPIDJSON_ASAN) && defined(__GNUC__)
+#define RAPIDJSON_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(RAPIDJSON_ASAN) && defined(_MSC_VER) && _MSC_VER >= 1928
+#define RAPIDJSON_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#elif defined(RAPIDJSON_ASAN)
+#define RAPIDJSON_NO_SANITIZE_ADDRESS
+#define RAPIDJSON_ASAN_NO_EXCLUDE // the kernels would be reported -> no SIMD by default
+#else
+#define RAPIDJSON_NO_SANITIZE_ADDRESS
+#endif
+
+/*! \def RAPIDJSON_SIMD_DISPATCH
+    \ingroup RAPIDJSON_CONFIG
+    \brief Select the SSE2/SSE4.2/AVX2 code paths at runtime.
+
+    If neither \c RAPIDJSON_SSE2 nor \c RAPIDJSON_SSE42 is defined, RapidJSON
+    compiles all variants on x86 with GCC, Clang and MSVC and picks the best one
+    the CPU supports when it is first used (see internal::GetSimdLevel() and
+    internal::SetSimdLevel()). Define \c RAPIDJSON_NO_SIMD_DISPATCH to keep the
+    scalar code paths instead.
+
+    With AddressSanitizer it is only enabled if the over-reading kernels can be
+    excluded from instrumentation (see \ref RAPIDJSON_NO_SANITIZE_ADDRESS).
+*/
+#if !defined(RAPIDJSON_SIMD_DISPATCH) && !defined(RAPIDJSON_NO_SIMD_DISPATCH) \
+    && !defined(RAPIDJSON_SSE2) && !defined(RAPIDJSON_SSE42) \
+    && (defined(__GNUC__) || defined(_MSC_VER)) \
+    && !defined(RAPIDJSON_ASAN_NO_EXCLUDE) \
+    && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define RAPIDJSON_SIMD_DISPATCH
+#endif
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH) \
     || defined(RAPIDJSON_DOXYGEN_RUNNING)
 #define RAPIDJSON_SIMD
 #endif
 
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSON_STATS
+
+#ifndef RAPIDJSON_STATS
+#define RAPIDJSON_STATS 0 // no statistics by default
+#endif
+/*! \def RAPIDJSON_STATS
+    \ingroup RAPIDJSON_CONFIG
+    \brief Collect memory statistics.
+
+    By defining this preprocessor symbol to \c 1, MemoryPoolAllocator counts
+    the requested and wasted bytes and its peak size (see MemoryPoolAllocator::GetStats()),
+    and internal::Stack records its high-water mark (see internal::Stack::GetHighWater()).
+    Otherwise the counters aren't compiled at all.
+
+    \note The counters change the layout of MemoryPoolAllocator and internal::Stack,
+    so the symbol must have the same value in every translation unit (define it
+    in the build settings, not in a source file). MSVC reports a mismatch at link time.
+*/
+#if defined(_MSC_VER) && !defined(RAPIDJSON_DOXYGEN_RUNNING)
+#if RAPIDJSON_STATS
+#pragma detect_mismatch("RAPIDJSON_STATS", "1")
+#else
+#pragma detect_mismatch("RAPIDJSON_STATS", "0")
+#endif
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // RAPIDJSON_NO_SIZETYPEDEFINE
 
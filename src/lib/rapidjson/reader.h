@@ -23,6 +23,7 @@
 #include "internal/meta.h"
 #include "internal/stack.h"
 #include "internal/strtod.h"
+#include "internal/simd.h"
 #include <limits>
 
 #if defined(RAPIDJSON_SIMD) && defined(_MSC_VER)
@@ -136,7 +137,7 @@ RAPIDJSON_NAMESPACE_BEGIN
     User can define this as any \c ParseFlag combinations.
 */
 #ifndef RAPIDJSON_PARSE_DEFAULT_FLAGS
-#define RAPIDJSON_PARSE_DEFAULT_FLAGS kParseNoFlags
+#define RAPIDJSON_PARSE_DEFAULT_FLAGS kParseFullPrecisionFlag
 #endif
 
 //! Combination of parseFlags
@@ -148,7 +149,7 @@ enum ParseFlag {
     kParseValidateEncodingFlag = 2, //!< Validate encoding of JSON strings.
     kParseIterativeFlag = 4,        //!< Iterative(constant complexity in terms of function call stack size) parsing.
     kParseStopWhenDoneFlag = 8,     //!< After parsing a complete JSON root from stream, stop further processing the rest of stream. When this flag is used, parser will not generate kParseErrorDocumentRootNotSingular error.
-    kParseFullPrecisionFlag = 16,   //!< Parse number in full precision (but slower).
+    kParseFullPrecisionFlag = 16,   //!< Parse number in full precision. Part of the default flags, numbers in memory are always rounded correctly.
     kParseCommentsFlag = 32,        //!< Allow one-line (//) and multi-line (/**/) comments.
     kParseNumbersAsStringsFlag = 64,    //!< Parse all numbers (ints/doubles) as strings.
     kParseTrailingCommasFlag = 128, //!< Allow trailing commas at the end of objects and arrays.
@@ -276,9 +277,9 @@ inline const char* SkipWhitespace(const char* p, const char* end) {
     return p;
 }
 
-#ifdef RAPIDJSON_SSE42
+#if defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
 //! Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
+RAPIDJSON_TARGET("sse4.2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *SkipWhitespace_SSE42(const char* p) {
     // Fast return for single non-whitespace
     if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
         ++p;
@@ -305,7 +306,7 @@ inline const char *SkipWhitespace_SIMD(const char* p) {
     }
 }
 
-inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
+RAPIDJSON_TARGET("sse4.2") inline const char *SkipWhitespace_SSE42(const char* p, const char* end) {
     // Fast return for single non-whitespace
     if (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
         ++p;
@@ -326,10 +327,12 @@ inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
     return SkipWhitespace(p, end);
 }
 
-#elif defined(RAPIDJSON_SSE2)
+#endif // RAPIDJSON_SSE42
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SIMD_DISPATCH)
 
 //! Skip whitespace with SSE2 instructions, testing 16 8-byte characters at once.
-inline const char *SkipWhitespace_SIMD(const char* p) {
+RAPIDJSON_TARGET("sse2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *SkipWhitespace_SSE2(const char* p) {
     // Fast return for single non-whitespace
     if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
         ++p;
@@ -373,7 +376,7 @@ inline const char *SkipWhitespace_SIMD(const char* p) {
     }
 }
 
-inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
+RAPIDJSON_TARGET("sse2") inline const char *SkipWhitespace_SSE2(const char* p, const char* end) {
     // Fast return for single non-whitespace
     if (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
         ++p;
@@ -413,6 +416,488 @@ inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
 
 #endif // RAPIDJSON_SSE2
 
+#ifdef RAPIDJSON_SIMD_DISPATCH
+//! Skip whitespace with AVX2 instructions, testing 32 8-byte characters at once.
+RAPIDJSON_TARGET("avx2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *SkipWhitespace_AVX2(const char* p) {
+    // Fast return for single non-whitespace
+    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        ++p;
+    else
+        return p;
+
+    // 16-byte align to the next boundary
+    const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
+    while (p != nextAligned)
+        if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+            ++p;
+        else
+            return p;
+
+    const __m256i w0 = _mm256_set1_epi8(' ');
+    const __m256i w1 = _mm256_set1_epi8('\n');
+    const __m256i w2 = _mm256_set1_epi8('\r');
+    const __m256i w3 = _mm256_set1_epi8('\t');
+
+    // One 16-byte block until 32-byte alignment
+    if (reinterpret_cast<size_t>(p) & 16) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i x = _mm_cmpeq_epi8(s, _mm256_castsi256_si128(w0));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm256_castsi256_si128(w1)));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm256_castsi256_si128(w2)));
+        x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm256_castsi256_si128(w3)));
+        unsigned short r = static_cast<unsigned short>(~_mm_movemask_epi8(x));
+        if (r != 0) {   // some of characters may be non-whitespace
+#ifdef _MSC_VER         // Find the index of first non-whitespace
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return p + offset;
+#else
+            return p + __builtin_ctz(r);
+#endif
+        }
+        p += 16;
+    }
+
+    // The rest of string
+
+    for (;; p += 32) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i x = _mm256_cmpeq_epi8(s, w0);
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w1));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w2));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w3));
+        unsigned r = ~static_cast<unsigned>(_mm256_movemask_epi8(x));
+        if (r != 0) {   // some of characters may be non-whitespace
+#ifdef _MSC_VER         // Find the index of first non-whitespace
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return p + offset;
+#else
+            return p + __builtin_ctz(r);
+#endif
+        }
+    }
+}
+
+RAPIDJSON_TARGET("avx2") inline const char *SkipWhitespace_AVX2(const char* p, const char* end) {
+    // Fast return for single non-whitespace
+    if (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        ++p;
+    else
+        return p;
+
+    // The rest of string
+    const __m256i w0 = _mm256_set1_epi8(' ');
+    const __m256i w1 = _mm256_set1_epi8('\n');
+    const __m256i w2 = _mm256_set1_epi8('\r');
+    const __m256i w3 = _mm256_set1_epi8('\t');
+
+    for (; end - p >= 32; p += 32) {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i x = _mm256_cmpeq_epi8(s, w0);
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w1));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w2));
+        x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, w3));
+        unsigned r = ~static_cast<unsigned>(_mm256_movemask_epi8(x));
+        if (r != 0) {   // some of characters may be non-whitespace
+#ifdef _MSC_VER         // Find the index of first non-whitespace
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return p + offset;
+#else
+            return p + __builtin_ctz(r);
+#endif
+        }
+    }
+
+    return SkipWhitespace(p, end);
+}
+
+//! Skip whitespace with the code path selected at runtime.
+inline const char *SkipWhitespace_SIMD(const char* p) {
+    switch (internal::GetSimdLevel()) {
+    case internal::kSimdAVX2:  return SkipWhitespace_AVX2(p);
+    case internal::kSimdSSE42: return SkipWhitespace_SSE42(p);
+    case internal::kSimdSSE2:  return SkipWhitespace_SSE2(p);
+    default:
+        while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+            ++p;
+        return p;
+    }
+}
+
+inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
+    switch (internal::GetSimdLevel()) {
+    case internal::kSimdAVX2:  return SkipWhitespace_AVX2(p, end);
+    case internal::kSimdSSE42: return SkipWhitespace_SSE42(p, end);
+    case internal::kSimdSSE2:  return SkipWhitespace_SSE2(p, end);
+    default:                   return SkipWhitespace(p, end);
+    }
+}
+
+#elif defined(RAPIDJSON_SSE42)
+inline const char *SkipWhitespace_SIMD(const char* p) { return SkipWhitespace_SSE42(p); }
+inline const char *SkipWhitespace_SIMD(const char* p, const char* end) { return SkipWhitespace_SSE42(p, end); }
+#elif defined(RAPIDJSON_SSE2)
+inline const char *SkipWhitespace_SIMD(const char* p) { return SkipWhitespace_SSE2(p); }
+inline const char *SkipWhitespace_SIMD(const char* p, const char* end) { return SkipWhitespace_SSE2(p, end); }
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
+
+//! Scan a string for the first '\"', '\\' or control character, with SSE2 instructions.
+/*! \param p Start of the scan in a null-terminated string.
+    \note The blocks are loaded 16-byte aligned, starting with the one containing \c p,
+          so reads never cross a page boundary and no scalar prelude is needed.
+*/
+RAPIDJSON_TARGET("sse2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *ScanUnescapedString_SSE2(const char* p) {
+    const __m128i dq = _mm_set1_epi8('\"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
+
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~15));
+    unsigned ignore = (1u << (p - q)) - 1;  // bytes before p
+    for (;; q += 16, ignore = 0) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(q));
+        const __m128i t1 = _mm_cmpeq_epi8(s, dq);
+        const __m128i t2 = _mm_cmpeq_epi8(s, bs);
+        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        const unsigned r = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(t1, t2), t3))) & ~ignore;
+        if (RAPIDJSON_UNLIKELY(r != 0)) {
+#ifdef _MSC_VER
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return q + offset;
+#else
+            return q + __builtin_ctz(r);
+#endif
+        }
+    }
+}
+
+#endif // RAPIDJSON_SSE2 || RAPIDJSON_SSE42 || RAPIDJSON_SIMD_DISPATCH
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+
+//! Scan a string for the first '\"', '\\' or control character, with AVX2 instructions.
+/*! \see ScanUnescapedString_SSE2
+*/
+RAPIDJSON_TARGET("avx2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *ScanUnescapedString_AVX2(const char* p) {
+    const __m256i dq = _mm256_set1_epi8('\"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~31));
+    unsigned ignore = static_cast<unsigned>((static_cast<uint64_t>(1) << (p - q)) - 1);  // bytes before p
+    for (;; q += 32, ignore = 0) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(q));
+        const __m256i t1 = _mm256_cmpeq_epi8(s, dq);
+        const __m256i t2 = _mm256_cmpeq_epi8(s, bs);
+        const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        const unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3))) & ~ignore;
+        if (RAPIDJSON_UNLIKELY(r != 0)) {
+#ifdef _MSC_VER
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return q + offset;
+#else
+            return q + __builtin_ctz(r);
+#endif
+        }
+    }
+}
+
+//! Select the string scanner at runtime, or return \c p to leave the string to the scalar path.
+inline const char *ScanUnescapedString_SIMD(const char* p) {
+    switch (internal::GetSimdLevel()) {
+    case internal::kSimdAVX2:  return ScanUnescapedString_AVX2(p);
+    case internal::kSimdSSE42:
+    case internal::kSimdSSE2:  return ScanUnescapedString_SSE2(p);
+    default:                   return p;
+    }
+}
+
+#elif defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+inline const char *ScanUnescapedString_SIMD(const char* p) { return ScanUnescapedString_SSE2(p); }
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+#if defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
+
+// Vectorized UTF-8 validation with the lookup-table algorithm of Keiser and Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte" (2021): three nibble lookups
+// classify every pair of adjacent bytes, the 3rd/4th continuation bytes are checked with
+// saturating subtractions.
+//!@cond RAPIDJSON_HIDDEN_FROM_DOXYGEN
+#define RAPIDJSON_UTF8_TOO_SHORT      (1 << 0)
+#define RAPIDJSON_UTF8_TOO_LONG       (1 << 1)
+#define RAPIDJSON_UTF8_OVERLONG_3     (1 << 2)
+#define RAPIDJSON_UTF8_TOO_LARGE      (1 << 3)
+#define RAPIDJSON_UTF8_SURROGATE      (1 << 4)
+#define RAPIDJSON_UTF8_OVERLONG_2     (1 << 5)
+#define RAPIDJSON_UTF8_TOO_LARGE_1000 (1 << 6)
+#define RAPIDJSON_UTF8_OVERLONG_4     (1 << 6)
+#define RAPIDJSON_UTF8_TWO_CONTS      (1 << 7)
+#define RAPIDJSON_UTF8_CARRY (RAPIDJSON_UTF8_TOO_SHORT | RAPIDJSON_UTF8_TOO_LONG | RAPIDJSON_UTF8_TWO_CONTS)
+
+// lookup by the high nibble of the first byte
+#define RAPIDJSON_UTF8_BYTE_1_HIGH \
+    RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, \
+    RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, RAPIDJSON_UTF8_TOO_LONG, \
+    RAPIDJSON_UTF8_TWO_CONTS, RAPIDJSON_UTF8_TWO_CONTS, RAPIDJSON_UTF8_TWO_CONTS, RAPIDJSON_UTF8_TWO_CONTS, \
+    RAPIDJSON_UTF8_TOO_SHORT | RAPIDJSON_UTF8_OVERLONG_2, \
+    RAPIDJSON_UTF8_TOO_SHORT, \
+    RAPIDJSON_UTF8_TOO_SHORT | RAPIDJSON_UTF8_OVERLONG_3 | RAPIDJSON_UTF8_SURROGATE, \
+    RAPIDJSON_UTF8_TOO_SHORT | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000 | RAPIDJSON_UTF8_OVERLONG_4
+
+// lookup by the low nibble of the first byte
+#define RAPIDJSON_UTF8_BYTE_1_LOW \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_OVERLONG_3 | RAPIDJSON_UTF8_OVERLONG_2 | RAPIDJSON_UTF8_OVERLONG_4, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_OVERLONG_2, \
+    RAPIDJSON_UTF8_CARRY, \
+    RAPIDJSON_UTF8_CARRY, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000 | RAPIDJSON_UTF8_SURROGATE, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000, \
+    RAPIDJSON_UTF8_CARRY | RAPIDJSON_UTF8_TOO_LARGE | RAPIDJSON_UTF8_TOO_LARGE_1000
+
+// lookup by the high nibble of the second byte
+#define RAPIDJSON_UTF8_BYTE_2_HIGH \
+    RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, \
+    RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, \
+    RAPIDJSON_UTF8_TOO_LONG | RAPIDJSON_UTF8_OVERLONG_2 | RAPIDJSON_UTF8_TWO_CONTS | RAPIDJSON_UTF8_OVERLONG_3 | RAPIDJSON_UTF8_TOO_LARGE_1000 | RAPIDJSON_UTF8_OVERLONG_4, \
+    RAPIDJSON_UTF8_TOO_LONG | RAPIDJSON_UTF8_OVERLONG_2 | RAPIDJSON_UTF8_TWO_CONTS | RAPIDJSON_UTF8_OVERLONG_3 | RAPIDJSON_UTF8_TOO_LARGE, \
+    RAPIDJSON_UTF8_TOO_LONG | RAPIDJSON_UTF8_OVERLONG_2 | RAPIDJSON_UTF8_TWO_CONTS | RAPIDJSON_UTF8_SURROGATE | RAPIDJSON_UTF8_TOO_LARGE, \
+    RAPIDJSON_UTF8_TOO_LONG | RAPIDJSON_UTF8_OVERLONG_2 | RAPIDJSON_UTF8_TWO_CONTS | RAPIDJSON_UTF8_SURROGATE | RAPIDJSON_UTF8_TOO_LARGE, \
+    RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT, RAPIDJSON_UTF8_TOO_SHORT
+
+// bytes which still need continuation bytes at the end of a block
+#define RAPIDJSON_UTF8_INCOMPLETE_16 \
+    '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', \
+    '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xEF', '\xDF', '\xBF'
+//!@endcond
+
+//! Scan a string for a run of valid UTF-8 without '\"', '\\' and control characters, with SSE4.2 instructions.
+/*! \param p Start of the run, must be a code point boundary in a null-terminated string.
+    \return End of the run. This is either the terminating character or a code point
+            boundary before invalid UTF-8, which is left to the scalar validator to report.
+    \note The blocks are loaded 16-byte aligned, so reads never cross a page boundary.
+*/
+RAPIDJSON_TARGET("sse4.2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *ScanValidString_SSE42(const char* p) {
+    static const char prefix[32] = {
+        '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF',
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const __m128i byte1High = _mm_setr_epi8(RAPIDJSON_UTF8_BYTE_1_HIGH);
+    const __m128i byte1Low = _mm_setr_epi8(RAPIDJSON_UTF8_BYTE_1_LOW);
+    const __m128i byte2High = _mm_setr_epi8(RAPIDJSON_UTF8_BYTE_2_HIGH);
+    const __m128i incomplete = _mm_setr_epi8(RAPIDJSON_UTF8_INCOMPLETE_16);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i third = _mm_set1_epi8(static_cast<char>(0xE0 - 0x80));
+    const __m128i fourth = _mm_set1_epi8(static_cast<char>(0xF0 - 0x80));
+    const __m128i hi = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i dq = _mm_set1_epi8('\"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
+    const __m128i zero = _mm_setzero_si128();
+
+    // Start at the 16-byte boundary before p and treat the bytes before p as ASCII
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~15));
+    const unsigned skip = static_cast<unsigned>(p - q);
+    __m128i s = _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&prefix[16 - skip])),
+                                 _mm_load_si128(reinterpret_cast<const __m128i *>(q)));
+    unsigned ignore = (1u << skip) - 1;
+    __m128i prev = zero;
+    bool pending = false;   // the previous block ended inside a multi-byte sequence
+    const char* boundary = p;
+
+    for (;;) {
+        const __m128i t1 = _mm_cmpeq_epi8(s, dq);
+        const __m128i t2 = _mm_cmpeq_epi8(s, bs);
+        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        const unsigned r = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(t1, t2), t3))) & ~ignore;
+        unsigned error = 0;
+        bool nonAscii = _mm_movemask_epi8(s) != 0;
+        if (nonAscii || pending) {
+            const __m128i prev1 = _mm_alignr_epi8(s, prev, 15);
+            const __m128i prev2 = _mm_alignr_epi8(s, prev, 14);
+            const __m128i prev3 = _mm_alignr_epi8(s, prev, 13);
+            const __m128i sc = _mm_and_si128(_mm_and_si128(
+                _mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+                _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(s, 4), nibble)));
+            const __m128i must23 = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(prev2, third), _mm_subs_epu8(prev3, fourth)), hi);
+            error = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_xor_si128(must23, sc), zero))) ^ 0xFFFF;
+        }
+
+        if (r != 0) {
+#ifdef _MSC_VER
+            unsigned long length;
+            _BitScanForward(&length, r);
+#else
+            const unsigned length = static_cast<unsigned>(__builtin_ctz(r));
+#endif
+            // the terminating character is ASCII, so it also reveals a truncated sequence before it
+            return (error & ((2u << length) - 1)) ? boundary : q + length;
+        }
+        if (error)
+            return boundary;
+
+        if (nonAscii) {
+            const unsigned tail = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(s, incomplete), zero))) ^ 0xFFFF;
+            pending = tail != 0;
+#ifdef _MSC_VER
+            unsigned long offset = 16;
+            if (tail)
+                _BitScanForward(&offset, tail);
+#else
+            const unsigned offset = tail ? static_cast<unsigned>(__builtin_ctz(tail)) : 16;
+#endif
+            boundary = q + offset;
+        }
+        else {
+            pending = false;
+            boundary = q + 16;
+        }
+
+        prev = s;
+        q += 16;
+        s = _mm_load_si128(reinterpret_cast<const __m128i *>(q));
+        ignore = 0;
+    }
+}
+
+#endif // RAPIDJSON_SSE42 || RAPIDJSON_SIMD_DISPATCH
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+
+//! Scan a string for a run of valid UTF-8 without '\"', '\\' and control characters, with AVX2 instructions.
+/*! \see ScanValidString_SSE42
+*/
+RAPIDJSON_TARGET("avx2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char *ScanValidString_AVX2(const char* p) {
+    static const char prefix[64] = {
+        '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF',
+        '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF',
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const __m256i byte1High = _mm256_setr_epi8(RAPIDJSON_UTF8_BYTE_1_HIGH, RAPIDJSON_UTF8_BYTE_1_HIGH);
+    const __m256i byte1Low = _mm256_setr_epi8(RAPIDJSON_UTF8_BYTE_1_LOW, RAPIDJSON_UTF8_BYTE_1_LOW);
+    const __m256i byte2High = _mm256_setr_epi8(RAPIDJSON_UTF8_BYTE_2_HIGH, RAPIDJSON_UTF8_BYTE_2_HIGH);
+    const __m256i incomplete = _mm256_setr_epi8(
+        '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF',
+        RAPIDJSON_UTF8_INCOMPLETE_16);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i third = _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80));
+    const __m256i fourth = _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80));
+    const __m256i hi = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i dq = _mm256_set1_epi8('\"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+    const __m256i zero = _mm256_setzero_si256();
+
+    // Start at the 32-byte boundary before p and treat the bytes before p as ASCII
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~31));
+    const unsigned skip = static_cast<unsigned>(p - q);
+    __m256i s = _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&prefix[32 - skip])),
+                                    _mm256_load_si256(reinterpret_cast<const __m256i *>(q)));
+    unsigned ignore = static_cast<unsigned>((static_cast<uint64_t>(1) << skip) - 1);
+    __m256i prev = zero;
+    bool pending = false;   // the previous block ended inside a multi-byte sequence
+    const char* boundary = p;
+
+    for (;;) {
+        const __m256i t1 = _mm256_cmpeq_epi8(s, dq);
+        const __m256i t2 = _mm256_cmpeq_epi8(s, bs);
+        const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        const unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3))) & ~ignore;
+        unsigned error = 0;
+        bool nonAscii = _mm256_movemask_epi8(s) != 0;
+        if (nonAscii || pending) {
+            // bytes shifted in from the previous block
+            const __m256i carry = _mm256_permute2x128_si256(prev, s, 0x21);
+            const __m256i prev1 = _mm256_alignr_epi8(s, carry, 15);
+            const __m256i prev2 = _mm256_alignr_epi8(s, carry, 14);
+            const __m256i prev3 = _mm256_alignr_epi8(s, carry, 13);
+            const __m256i sc = _mm256_and_si256(_mm256_and_si256(
+                _mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, nibble))),
+                _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(s, 4), nibble)));
+            const __m256i must23 = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(prev2, third), _mm256_subs_epu8(prev3, fourth)), hi);
+            error = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_xor_si256(must23, sc), zero)));
+        }
+
+        if (r != 0) {
+#ifdef _MSC_VER
+            unsigned long length;
+            _BitScanForward(&length, r);
+#else
+            const unsigned length = static_cast<unsigned>(__builtin_ctz(r));
+#endif
+            // the terminating character is ASCII, so it also reveals a truncated sequence before it
+            return (error & static_cast<unsigned>((static_cast<uint64_t>(2) << length) - 1)) ? boundary : q + length;
+        }
+        if (error)
+            return boundary;
+
+        if (nonAscii) {
+            const unsigned tail = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(s, incomplete), zero)));
+            pending = tail != 0;
+#ifdef _MSC_VER
+            unsigned long offset = 32;
+            if (tail)
+                _BitScanForward(&offset, tail);
+#else
+            const unsigned offset = tail ? static_cast<unsigned>(__builtin_ctz(tail)) : 32;
+#endif
+            boundary = q + offset;
+        }
+        else {
+            pending = false;
+            boundary = q + 32;
+        }
+
+        prev = s;
+        q += 32;
+        s = _mm256_load_si256(reinterpret_cast<const __m256i *>(q));
+        ignore = 0;
+    }
+}
+
+//! Select the validating string scanner at runtime, or return \c p to leave the string to the scalar path.
+inline const char *ScanValidString_SIMD(const char* p) {
+    switch (internal::GetSimdLevel()) {
+    case internal::kSimdAVX2:  return ScanValidString_AVX2(p);
+    case internal::kSimdSSE42: return ScanValidString_SSE42(p);
+    default:                   return p;
+    }
+}
+
+#elif defined(RAPIDJSON_SSE42)
+inline const char *ScanValidString_SIMD(const char* p) { return ScanValidString_SSE42(p); }
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+//!@cond RAPIDJSON_HIDDEN_FROM_DOXYGEN
+#undef RAPIDJSON_UTF8_TOO_SHORT
+#undef RAPIDJSON_UTF8_TOO_LONG
+#undef RAPIDJSON_UTF8_OVERLONG_3
+#undef RAPIDJSON_UTF8_TOO_LARGE
+#undef RAPIDJSON_UTF8_SURROGATE
+#undef RAPIDJSON_UTF8_OVERLONG_2
+#undef RAPIDJSON_UTF8_TOO_LARGE_1000
+#undef RAPIDJSON_UTF8_OVERLONG_4
+#undef RAPIDJSON_UTF8_TWO_CONTS
+#undef RAPIDJSON_UTF8_CARRY
+#undef RAPIDJSON_UTF8_BYTE_1_HIGH
+#undef RAPIDJSON_UTF8_BYTE_1_LOW
+#undef RAPIDJSON_UTF8_BYTE_2_HIGH
+#undef RAPIDJSON_UTF8_INCOMPLETE_16
+//!@endcond
+
 #ifdef RAPIDJSON_SIMD
 //! Template function specialization for InsituStringStream
 template<> inline void SkipWhitespace(InsituStringStream& is) {
@@ -457,7 +942,10 @@ public:
     /*! \param stackAllocator Optional allocator for allocating stack memory. (Only use for non-destructive parsing)
         \param stackCapacity stack capacity in bytes for storing a single decoded string.  (Only use for non-destructive parsing)
     */
-    GenericReader(StackAllocator* stackAllocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(stackAllocator, stackCapacity), parseResult_() {}
+    GenericReader(StackAllocator* stackAllocator = 0, size_t stackCapacity = kDefaultStackCapacity) : stack_(stackAllocator, stackCapacity), parseResult_(), state_(IterativeParsingStartState) {}
+
+    //! Exchange the stack for decoding strings with another one, e.g. to keep its memory across readers.
+    void SwapStack(internal::Stack<StackAllocator>& stack) { stack_.Swap(stack); }
 
     //! Parse JSON text.
     /*! \tparam parseFlags Combination of \ref ParseFlag.
@@ -513,6 +1001,91 @@ public:
         return Parse<kParseDefaultFlags>(is, handler);
     }
 
+    //! Initialize JSON text token-by-token parsing
+    /*!
+     */
+    RAPIDJSON_FORCEINLINE void IterativeParseInit() {
+        parseResult_.Clear();
+        stack_.Clear();
+        state_ = IterativeParsingStartState;
+    }
+
+    //! Parse one token from JSON text
+    /*! Uses the iterative parsing state machine, so the handler receives
+        exactly one event per successful call.
+        \tparam InputStream Type of input stream, implementing Stream concept
+        \tparam Handler Type of handler, implementing Handler concept.
+        \param is Input stream to be parsed.
+        \param handler The handler to receive events.
+        \return Whether the parsing is successful.
+     */
+    template <unsigned parseFlags, typename InputStream, typename Handler>
+    bool IterativeParseNext(InputStream& is, Handler& handler) {
+        while (RAPIDJSON_LIKELY(is.Peek() != '\0')) {
+            SkipWhitespaceAndComments<parseFlags>(is);
+            RAPIDJSON_PARSE_ERROR_EARLY_RETURN(false);
+
+            if (state_ == IterativeParsingFinishState || is.Peek() == '\0')
+                break;
+
+            Token t = Tokenize(is.Peek());
+            IterativeParsingState n = Predict(state_, t);
+            IterativeParsingState d = Transit<parseFlags>(state_, t, n, is, handler);
+
+            // If we've finished or hit an error...
+            if (RAPIDJSON_UNLIKELY(IsIterativeParsingCompleteState(d))) {
+                // Report errors.
+                if (d == IterativeParsingErrorState) {
+                    HandleError(state_, is);
+                    return false;
+                }
+
+                // Transition to the finish state.
+                RAPIDJSON_ASSERT(d == IterativeParsingFinishState);
+                state_ = d;
+
+                // If StopWhenDone is not set...
+                if (!(parseFlags & kParseStopWhenDoneFlag)) {
+                    // ... and extra non-whitespace data is found...
+                    SkipWhitespaceAndComments<parseFlags>(is);
+                    RAPIDJSON_PARSE_ERROR_EARLY_RETURN(false);
+                    if (is.Peek() != '\0') {
+                        // ... this is considered an error.
+                        HandleError(state_, is);
+                        return false;
+                    }
+                }
+
+                // Success! We are done!
+                return true;
+            }
+
+            // Transition to the new state.
+            state_ = d;
+
+            // If we parsed anything other than a delimiter, we invoked the handler, so we can return true now.
+            if (!IsIterativeParsingDelimiterState(n))
+                return true;
+        }
+
+        // We reached the end of file.
+        stack_.Clear();
+
+        if (state_ != IterativeParsingFinishState) {
+            HandleError(state_, is);
+            return false;
+        }
+
+        return true;
+    }
+
+    //! Check if token-by-token parsing JSON text is complete
+    /*! \return Whether the JSON has been fully decoded.
+     */
+    RAPIDJSON_FORCEINLINE bool IterativeParseComplete() const {
+        return IsIterativeParsingCompleteState(state_);
+    }
+
     //! Whether a parse error has occured in the last parsing.
     bool HasParseError() const { return parseResult_.IsError(); }
 
@@ -840,6 +1413,8 @@ private:
             // Scan and copy string before "\\\"" or < 0x20. This is an optional optimzation.
             if (!(parseFlags & kParseValidateEncodingFlag))
                 ScanCopyUnescapedString(is, os);
+            else if (internal::IsSame<SEncoding, UTF8<char> >::Value && internal::IsSame<TEncoding, UTF8<char> >::Value)
+                ScanCopyValidUnescapedString(is, os);  // same, but also stop before invalid UTF-8
 
             Ch c = is.Peek();
             if (RAPIDJSON_UNLIKELY(c == '\\')) {    // Escape
@@ -895,160 +1470,54 @@ private:
             // Do nothing for generic version
     }
 
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+    template<typename InputStream, typename OutputStream>
+    static RAPIDJSON_FORCEINLINE void ScanCopyValidUnescapedString(InputStream&, OutputStream&) {
+            // Do nothing for generic version
+    }
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
     // StringStream -> StackStream<char>
     static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
-        const char* p = is.src_;
-
-        // Scan one by one until alignment (unaligned load may cross page boundary and cause crash)
-        const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-        while (p != nextAligned)
-            if (RAPIDJSON_UNLIKELY(*p == '\"') || RAPIDJSON_UNLIKELY(*p == '\\') || RAPIDJSON_UNLIKELY(static_cast<unsigned>(*p) < 0x20)) {
-                is.src_ = p;
-                return;
-            }
-            else
-                os.Put(*p++);
-
-        // The rest of string using SIMD
-        static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
-        static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16]  = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
-        const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
-        const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
-        const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
-
-        for (;; p += 16) {
-            const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-            const __m128i t1 = _mm_cmpeq_epi8(s, dq);
-            const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
-            const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
-            unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
-            if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
-                SizeType length;
-    #ifdef _MSC_VER         // Find the index of first escaped
-                unsigned long offset;
-                _BitScanForward(&offset, r);
-                length = offset;
-    #else
-                length = static_cast<SizeType>(__builtin_ffs(r) - 1);
-    #endif
-                char* q = reinterpret_cast<char*>(os.Push(length));
-                for (size_t i = 0; i < length; i++)
-                    q[i] = p[i];
-
-                p += length;
-                break;
-            }
-            _mm_storeu_si128(reinterpret_cast<__m128i *>(os.Push(16)), s);
-        }
-
-        is.src_ = p;
+        CopyScannedString(is, os, ScanUnescapedString_SIMD(is.src_));
     }
 
     // InsituStringStream -> InsituStringStream
     static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, InsituStringStream& os) {
-        RAPIDJSON_ASSERT(&is == &os);
-        (void)os;
+        CopyScannedString(is, os, ScanUnescapedString_SIMD(is.src_));
+    }
 
-        if (is.src_ == is.dst_) {
-            SkipUnescapedString(is);
-            return;
+    // Copy the run [is.src_, end) found by a scanner in one go
+    static RAPIDJSON_FORCEINLINE void CopyScannedString(StringStream& is, StackStream<char>& os, const char* end) {
+        if (end != is.src_) {
+            SizeType length = static_cast<SizeType>(end - is.src_);
+            std::memcpy(os.Push(length), is.src_, length);
+            is.src_ = end;
         }
+    }
 
-        char* p = is.src_;
-        char *q = is.dst_;
+    static RAPIDJSON_FORCEINLINE void CopyScannedString(InsituStringStream& is, InsituStringStream& os, const char* end) {
+        RAPIDJSON_ASSERT(&is == &os);
+        (void)os;
 
-        // Scan one by one until alignment (unaligned load may cross page boundary and cause crash)
-        const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-        while (p != nextAligned)
-            if (RAPIDJSON_UNLIKELY(*p == '\"') || RAPIDJSON_UNLIKELY(*p == '\\') || RAPIDJSON_UNLIKELY(static_cast<unsigned>(*p) < 0x20)) {
-                is.src_ = p;
-                is.dst_ = q;
-                return;
-            }
-            else
-                *q++ = *p++;
-
-        // The rest of string using SIMD
-        static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
-        static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16] = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
-        const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
-        const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
-        const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
-
-        for (;; p += 16, q += 16) {
-            const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-            const __m128i t1 = _mm_cmpeq_epi8(s, dq);
-            const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
-            const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
-            unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
-            if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
-                size_t length;
-#ifdef _MSC_VER         // Find the index of first escaped
-                unsigned long offset;
-                _BitScanForward(&offset, r);
-                length = offset;
-#else
-                length = static_cast<size_t>(__builtin_ffs(r) - 1);
-#endif
-                for (const char* pend = p + length; p != pend; )
-                    *q++ = *p++;
-                break;
-            }
-            _mm_storeu_si128(reinterpret_cast<__m128i *>(q), s);
+        if (end != is.src_) {
+            size_t length = static_cast<size_t>(end - is.src_);
+            if (is.dst_ != is.src_) // otherwise just skip unescaped characters
+                std::memmove(is.dst_, is.src_, length);
+            is.src_ += length;
+            is.dst_ += length;
         }
-
-        is.src_ = p;
-        is.dst_ = q;
     }
-
-    // When read/write pointers are the same for insitu stream, just skip unescaped characters
-    static RAPIDJSON_FORCEINLINE void SkipUnescapedString(InsituStringStream& is) {
-        RAPIDJSON_ASSERT(is.src_ == is.dst_);
-        char* p = is.src_;
-
-        // Scan one by one until alignment (unaligned load may cross page boundary and cause crash)
-        const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-        for (; p != nextAligned; p++)
-            if (RAPIDJSON_UNLIKELY(*p == '\"') || RAPIDJSON_UNLIKELY(*p == '\\') || RAPIDJSON_UNLIKELY(static_cast<unsigned>(*p) < 0x20)) {
-                is.src_ = is.dst_ = p;
-                return;
-            }
-
-        // The rest of string using SIMD
-        static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
-        static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16] = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
-        const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
-        const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
-        const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
-
-        for (;; p += 16) {
-            const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-            const __m128i t1 = _mm_cmpeq_epi8(s, dq);
-            const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
-            const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
-            unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
-            if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
-                size_t length;
-#ifdef _MSC_VER         // Find the index of first escaped
-                unsigned long offset;
-                _BitScanForward(&offset, r);
-                length = offset;
-#else
-                length = static_cast<size_t>(__builtin_ffs(r) - 1);
 #endif
-                p += length;
-                break;
-            }
-        }
 
-        is.src_ = is.dst_ = p;
+#if defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
+    // StringStream -> StackStream<char>
+    static RAPIDJSON_FORCEINLINE void ScanCopyValidUnescapedString(StringStream& is, StackStream<char>& os) {
+        CopyScannedString(is, os, ScanValidString_SIMD(is.src_));
+    }
+
+    // InsituStringStream -> InsituStringStream
+    static RAPIDJSON_FORCEINLINE void ScanCopyValidUnescapedString(InsituStringStream& is, InsituStringStream& os) {
+        CopyScannedString(is, os, ScanValidString_SIMD(is.src_));
     }
 #endif
 
@@ -1112,8 +1581,201 @@ private:
         RAPIDJSON_FORCEINLINE Ch Take() { return Base::TakePush(); }
     };
 
+    // Parse a number in contiguous memory from [p, end), or up to '\0' if not bounded.
+    // Digits are converted 8 at a time (SWAR) and doubles are rounded correctly with
+    // Eisel-Lemire. Returns the end of the number, or 0 without calling the handler
+    // if the number needs the general path below: NaN/Inf, syntax errors, integers
+    // beyond 19 digits and the rare cases Eisel-Lemire can't decide.
+    template<bool bounded, typename Handler>
+    static const char* ParseNumberFast(const char* p, const char* end, Handler& handler, ParseErrorCode* error) {
+#define RAPIDJSON_PEEK(q) ((!bounded || (q) < end) ? *(q) : '\0')
+#define RAPIDJSON_ISDIGIT(c) (static_cast<unsigned>((c) - '0') <= 9)
+        const bool minus = *p == '-';
+        if (minus && (bounded && p + 1 == end))
+            return 0;
+        p += minus;
+
+        // int = zero / ( digit1-9 *DIGIT ), the significand is accumulated over all digits
+        const char* intBegin = p;
+        uint64_t w = 0;
+        if (*p == '0')
+            ++p;
+        else if (RAPIDJSON_ISDIGIT(*p)) {
+            // 8 digits at a time as long as the load stays in the buffer (or in the page)
+            while ((bounded ? end - p >= 8 : (reinterpret_cast<size_t>(p) & 4095) <= 4096 - 8)) {
+                const uint64_t v = internal::LoadEightChars(p);
+                if (!internal::IsEightDigits(v))
+                    break;
+                w = w * 100000000u + internal::ParseEightDigits(v);
+                p += 8;
+            }
+            for (char c; RAPIDJSON_ISDIGIT(c = RAPIDJSON_PEEK(p)); ++p)
+                w = w * 10u + static_cast<unsigned>(c - '0');
+        }
+        else
+            return 0;
+        const char* intEnd = p;
+
+        // frac = decimal-point 1*DIGIT
+        const char* fracBegin = p;
+        bool isDouble = false;
+        if (RAPIDJSON_PEEK(p) == '.') {
+            fracBegin = ++p;
+            while ((bounded ? end - p >= 8 : (reinterpret_cast<size_t>(p) & 4095) <= 4096 - 8)) {
+                const uint64_t v = internal::LoadEightChars(p);
+                if (!internal::IsEightDigits(v))
+                    break;
+                w = w * 100000000u + internal::ParseEightDigits(v);
+                p += 8;
+            }
+            for (char c; RAPIDJSON_ISDIGIT(c = RAPIDJSON_PEEK(p)); ++p)
+                w = w * 10u + static_cast<unsigned>(c - '0');
+            if (p == fracBegin)
+                return 0;
+            isDouble = true;
+        }
+        const char* fracEnd = p;
+
+        // exp = e [ minus / plus ] 1*DIGIT
+        int exp = 0;
+        char c = RAPIDJSON_PEEK(p);
+        if (c == 'e' || c == 'E') {
+            ++p;
+            c = RAPIDJSON_PEEK(p);
+            const bool expMinus = c == '-';
+            if (c == '+' || c == '-') {
+                ++p;
+                c = RAPIDJSON_PEEK(p);
+            }
+            if (!RAPIDJSON_ISDIGIT(c))
+                return 0;
+            for (; RAPIDJSON_ISDIGIT(c); ++p, c = RAPIDJSON_PEEK(p)) {
+                if (exp >= 10000) // far beyond the range of double, let the general path decide
+                    return 0;
+                exp = exp * 10 + (c - '0');
+            }
+            if (expMinus)
+                exp = -exp;
+            isDouble = true;
+        }
+
+        int digits = static_cast<int>((intEnd - intBegin) + (fracEnd - fracBegin));
+        if (!isDouble) {
+            if (digits > 19)
+                return 0;
+            bool cont = true;
+            if (minus) {
+                if (w <= 2147483648u)
+                    cont = handler.Int(static_cast<int32_t>(~static_cast<unsigned>(w) + 1));
+                else if (w <= RAPIDJSON_UINT64_C2(0x80000000, 0x00000000))
+                    cont = handler.Int64(static_cast<int64_t>(~w + 1));
+                else
+                    isDouble = true;
+            }
+            else if (w <= 0xFFFFFFFFu)
+                cont = handler.Uint(static_cast<unsigned>(w));
+            else
+                cont = handler.Uint64(w);
+            if (!isDouble) {
+                if (RAPIDJSON_UNLIKELY(!cont))
+                    *error = kParseErrorTermination;
+                return p;
+            }
+        }
+
+        int q = exp - static_cast<int>(fracEnd - fracBegin);
+        bool truncated = false;
+        if (digits > 19) {
+            // Leading zeros don't count
+            const char* d = intBegin;
+            for (; d != intEnd && *d == '0'; ++d)
+                digits--;
+            if (d == intEnd)
+                for (d = fracBegin; d != fracEnd && *d == '0'; ++d)
+                    digits--;
+            if (digits > 19) {
+                // Keep the first 19 significant digits, d points to the first one
+                truncated = true;
+                q += digits - 19;
+                w = 0;
+                for (int n = 0; n < 19; ++d) {
+                    if (d == intEnd)
+                        d = fracBegin;
+                    w = w * 10u + static_cast<unsigned>(*d - '0');
+                    ++n;
+                }
+            }
+        }
+
+        double result;
+        if (!truncated && w <= RAPIDJSON_UINT64_C2(0x001FFFFF, 0xFFFFFFFF) && q >= -22 && q <= 22)
+            result = q >= 0 ? static_cast<double>(w) * internal::Pow10(q) : static_cast<double>(w) / internal::Pow10(-q); // exact
+        else if (!(truncated ? internal::StrtodEiselLemireTruncated(w, q, &result) : internal::StrtodEiselLemire(w, q, &result)))
+            return 0;
+
+        if (RAPIDJSON_UNLIKELY(result > (std::numeric_limits<double>::max)()))
+            *error = kParseErrorNumberTooBig;
+        else if (RAPIDJSON_UNLIKELY(!handler.Double(minus ? -result : result)))
+            *error = kParseErrorTermination;
+        return p;
+#undef RAPIDJSON_ISDIGIT
+#undef RAPIDJSON_PEEK
+    }
+
+    template<unsigned parseFlags, typename InputStream, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParseNumberFast(InputStream&, Handler&) {
+        return false; // no contiguous memory
+    }
+
+    template<unsigned parseFlags, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParseNumberFast(StringStream& is, Handler& handler) {
+        ParseErrorCode error = kParseErrorNone;
+        const char* p = ParseNumberFast<false>(is.src_, 0, handler, &error);
+        if (!p)
+            return false;
+        if (RAPIDJSON_UNLIKELY(error != kParseErrorNone))
+            RAPIDJSON_PARSE_ERROR_NORETURN(error, is.Tell());
+        is.src_ = p;
+        return true;
+    }
+
+    template<unsigned parseFlags, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParseNumberFast(InsituStringStream& is, Handler& handler) {
+        ParseErrorCode error = kParseErrorNone;
+        const char* p = ParseNumberFast<false>(is.src_, 0, handler, &error);
+        if (!p)
+            return false;
+        if (RAPIDJSON_UNLIKELY(error != kParseErrorNone))
+            RAPIDJSON_PARSE_ERROR_NORETURN(error, is.Tell());
+        is.src_ += p - is.src_;
+        return true;
+    }
+
+    template<unsigned parseFlags, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParseNumberFast(MemoryStream& is, Handler& handler) {
+        if (is.src_ == is.end_)
+            return false;
+        ParseErrorCode error = kParseErrorNone;
+        const char* p = ParseNumberFast<true>(is.src_, is.end_, handler, &error);
+        if (!p)
+            return false;
+        if (RAPIDJSON_UNLIKELY(error != kParseErrorNone))
+            RAPIDJSON_PARSE_ERROR_NORETURN(error, is.Tell());
+        is.src_ = p;
+        return true;
+    }
+
+    template<unsigned parseFlags, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParseNumberFast(EncodedInputStream<UTF8<>, MemoryStream>& is, Handler& handler) {
+        return ParseNumberFast<parseFlags>(is.is_, handler);
+    }
+
     template<unsigned parseFlags, typename InputStream, typename Handler>
     void ParseNumber(InputStream& is, Handler& handler) {
+        // Numbers in memory take the fast path unless they are to be kept as strings
+        if (!(parseFlags & kParseNumbersAsStringsFlag) && ParseNumberFast<parseFlags>(is, handler))
+            return;
+
         internal::StreamLocalCopy<InputStream> copy(is);
         NumberStream<InputStream,
             ((parseFlags & kParseNumbersAsStringsFlag) != 0) ?
@@ -1346,6 +2008,10 @@ private:
                else
                    d = internal::StrtodNormalPrecision(d, p);
 
+               // Use > max, instead of == inf, to fix bogus warning -Wfloat-equal
+               if (RAPIDJSON_UNLIKELY(d > (std::numeric_limits<double>::max)()))
+                   RAPIDJSON_PARSE_ERROR(kParseErrorNumberTooBig, startOffset);
+
                cont = handler.Double(minus ? -d : d);
            }
            else if (useNanOrInf) {
@@ -1435,6 +2101,14 @@ private:
         kTokenCount
     };
 
+    RAPIDJSON_FORCEINLINE bool IsIterativeParsingDelimiterState(IterativeParsingState s) const {
+        return s == IterativeParsingKeyValueDelimiterState || s == IterativeParsingMemberDelimiterState || s == IterativeParsingElementDelimiterState;
+    }
+
+    RAPIDJSON_FORCEINLINE bool IsIterativeParsingCompleteState(IterativeParsingState s) const {
+        return s == IterativeParsingFinishState || s == IterativeParsingErrorState;
+    }
+
     RAPIDJSON_FORCEINLINE Token Tokenize(Ch c) {
 
 //!@cond RAPIDJSON_HIDDEN_FROM_DOXYGEN
@@ -1839,6 +2513,7 @@ private:
     static const size_t kDefaultStackCapacity = 256;    //!< Default stack capacity in bytes for storing a single decoded string.
     internal::Stack<StackAllocator> stack_;  //!< A stack for storing decoded string temporarily during non-destructive parsing.
     ParseResult parseResult_;
+    IterativeParsingState state_;  //!< State of token-by-token parsing.
 }; // class GenericReader
 
 //! Reader with UTF8 encoding and default allocator.
@@ -92,6 +92,15 @@ inline void PutUnsafe(Stream& stream, typename Stream::Ch c) {
     stream.Put(c);
 }
 
+//! Write a run of characters to a stream, presuming buffer is reserved.
+/*! Streams which can copy the whole run at once (memcpy, fwrite, ...) overload this.
+*/
+template<typename Stream>
+inline void PutUnsafe(Stream& stream, const typename Stream::Ch* s, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        PutUnsafe(stream, s[i]);
+}
+
 //! Put N copies of a character to a stream.
 template<typename Stream, typename Ch>
 inline void PutN(Stream& stream, Ch c, size_t n) {
@@ -106,6 +106,11 @@ inline void PutUnsafe(GenericStringBuffer<Encoding, Allocator>& stream, typename
     stream.PutUnsafe(c);
 }
 
+template<typename Encoding, typename Allocator>
+inline void PutUnsafe(GenericStringBuffer<Encoding, Allocator>& stream, const typename Encoding::Ch* s, size_t n) {
+    std::memcpy(stream.stack_.template PushUnsafe<typename Encoding::Ch>(n), s, n * sizeof(*s));
+}
+
 //! Implement specialized version of PutN() with memset() for better performance.
 template<>
 inline void PutN(GenericStringBuffer<UTF8<> >& stream, char c, size_t n) {
@@ -20,6 +20,7 @@
 #include "internal/strfunc.h"
 #include "internal/dtoa.h"
 #include "internal/itoa.h"
+#include "internal/simd.h"
 #include "stringbuffer.h"
 #include <new>      // placement new
 
@@ -68,6 +69,118 @@ enum WriteFlag {
     kWriteDefaultFlags = RAPIDJSON_WRITE_DEFAULT_FLAGS  //!< Default write flags. Can be customized by defining RAPIDJSON_WRITE_DEFAULT_FLAGS
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// ScanWriteUnescapedString
+
+namespace internal {
+
+//! Find the first character in [p, end) which needs escaping ('\"', '\\' or a control character).
+/*! \return The position of that character or \c end.
+*/
+inline const char* ScanWriteUnescapedString(const char* p, const char* end) {
+    for (; p != end; ++p) {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x20 || c == '\"' || c == '\\')
+            break;
+    }
+    return p;
+}
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH)
+
+//! ScanWriteUnescapedString() with SSE2 instructions.
+/*! \note The blocks are loaded 16-byte aligned, from the one containing \c p to the one containing \c end - 1,
+          so reads never cross a page boundary and neither a scalar prelude nor a scalar tail is needed.
+*/
+RAPIDJSON_TARGET("sse2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char* ScanWriteUnescapedString_SSE2(const char* p, const char* end) {
+    if (p == end)
+        return p;
+    const __m128i dq = _mm_set1_epi8('\"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(0x1F);
+
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~15));
+    unsigned ignore = (1u << (p - q)) - 1;  // bytes before p
+    for (;; q += 16, ignore = 0) {
+        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(q));
+        const __m128i t1 = _mm_cmpeq_epi8(s, dq);
+        const __m128i t2 = _mm_cmpeq_epi8(s, bs);
+        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        unsigned r = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(t1, t2), t3))) & ~ignore;
+        const bool last = end - q <= 16;
+        if (last)
+            r &= (1u << (end - q)) - 1; // bytes from end on
+        if (r != 0) {
+#ifdef _MSC_VER
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return q + offset;
+#else
+            return q + __builtin_ctz(r);
+#endif
+        }
+        if (last)
+            return end;
+    }
+}
+
+#endif // RAPIDJSON_SSE2 || RAPIDJSON_SSE42 || RAPIDJSON_SIMD_DISPATCH
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+
+//! ScanWriteUnescapedString() with AVX2 instructions.
+/*! \see ScanWriteUnescapedString_SSE2
+*/
+RAPIDJSON_TARGET("avx2") RAPIDJSON_NO_SANITIZE_ADDRESS inline const char* ScanWriteUnescapedString_AVX2(const char* p, const char* end) {
+    if (p == end)
+        return p;
+    const __m256i dq = _mm256_set1_epi8('\"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+
+    const char* q = reinterpret_cast<const char*>(reinterpret_cast<size_t>(p) & static_cast<size_t>(~31));
+    unsigned ignore = static_cast<unsigned>((static_cast<uint64_t>(1) << (p - q)) - 1);  // bytes before p
+    for (;; q += 32, ignore = 0) {
+        const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i *>(q));
+        const __m256i t1 = _mm256_cmpeq_epi8(s, dq);
+        const __m256i t2 = _mm256_cmpeq_epi8(s, bs);
+        const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+        unsigned r = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3))) & ~ignore;
+        const bool last = end - q <= 32;
+        if (last)
+            r &= static_cast<unsigned>((static_cast<uint64_t>(1) << (end - q)) - 1); // bytes from end on
+        if (r != 0) {
+#ifdef _MSC_VER
+            unsigned long offset;
+            _BitScanForward(&offset, r);
+            return q + offset;
+#else
+            return q + __builtin_ctz(r);
+#endif
+        }
+        if (last)
+            return end;
+    }
+}
+
+//! Select the escape scanner at runtime.
+inline const char* ScanWriteUnescapedString_SIMD(const char* p, const char* end) {
+    switch (GetSimdLevel()) {
+    case kSimdAVX2:  return ScanWriteUnescapedString_AVX2(p, end);
+    case kSimdSSE42:
+    case kSimdSSE2:  return ScanWriteUnescapedString_SSE2(p, end);
+    default:         return ScanWriteUnescapedString(p, end);
+    }
+}
+
+#elif defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+inline const char* ScanWriteUnescapedString_SIMD(const char* p, const char* end) { return ScanWriteUnescapedString_SSE2(p, end); }
+#else
+inline const char* ScanWriteUnescapedString_SIMD(const char* p, const char* end) { return ScanWriteUnescapedString(p, end); }
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+} // namespace internal
+
 //! JSON writer
 /*! Writer implements the concept Handler.
     It generates JSON text by events to an output os.
@@ -150,6 +263,7 @@ public:
     //! Sets the maximum number of decimal places for double output.
     /*!
         This setting truncates the output with specified number of decimal places.
+        It applies to both Double() and Float().
 
         For example, 
 
@@ -191,6 +305,16 @@ public:
     */
     bool Double(double d)       { Prefix(kNumberType); return EndValue(WriteDouble(d)); }
 
+    //! Writes the given \c float value to the stream
+    /*!
+        Unlike Double(), this writes the shortest representation which reads back
+        as the same \c float, e.g. "0.1" instead of "0.10000000149011612".
+        SetMaxDecimalPlaces() applies as well.
+        \param f The value to be written.
+        \return Whether it is succeed.
+    */
+    bool Float(float f)         { Prefix(kNumberType); return EndValue(WriteFloat(f)); }
+
     bool RawNumber(const Ch* str, SizeType length, bool copy = false) {
         RAPIDJSON_ASSERT(str != 0);
         (void)copy;
@@ -356,6 +480,18 @@ protected:
         return true;
     }
 
+    bool WriteFloat(float f) {
+        if (internal::Double(static_cast<double>(f)).IsNanOrInf())
+            return WriteDouble(static_cast<double>(f));
+
+        char buffer[25];
+        char* end = internal::ftoa(f, buffer, maxDecimalPlaces_);
+        PutReserve(*os_, static_cast<size_t>(end - buffer));
+        for (char* p = buffer; p != end; ++p)
+            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        return true;
+    }
+
     bool WriteString(const Ch* str, SizeType length)  {
         static const typename TargetEncoding::Ch hexDigits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
         static const char escape[256] = {
@@ -430,10 +566,30 @@ protected:
         return true;
     }
 
+    //! Copy the run of characters which need no escaping and return whether the string continues.
+    /*! Only UTF-8 to UTF-8 without validation can be copied verbatim; all other combinations
+        are transcoded character by character in WriteString().
+    */
     bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length) {
+        typedef internal::BoolType<internal::IsSame<SourceEncoding, UTF8<char> >::Value
+            && internal::IsSame<TargetEncoding, UTF8<char> >::Value
+            && !(writeFlags & kWriteValidateEncodingFlag)> CopyVerbatim;
+        return ScanWriteUnescapedString(is, length, CopyVerbatim());
+    }
+
+    bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length, internal::FalseType) {
         return RAPIDJSON_LIKELY(is.Tell() < length);
     }
 
+    bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length, internal::TrueType) {
+        const char* p = is.src_;
+        const char* end = is.head_ + length;
+        const char* q = internal::ScanWriteUnescapedString_SIMD(p, end);
+        PutUnsafe(*os_, p, static_cast<size_t>(q - p)); // space has been reserved by WriteString()
+        is.src_ = q;
+        return RAPIDJSON_LIKELY(q != end);
+    }
+
     bool WriteStartObject() { os_->Put('{'); return true; }
     bool WriteEndObject()   { os_->Put('}'); return true; }
     bool WriteStartArray()  { os_->Put('['); return true; }
@@ -548,68 +704,16 @@ inline bool Writer<StringBuffer>::WriteDouble(double d) {
     return true;
 }
 
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
 template<>
-inline bool Writer<StringBuffer>::ScanWriteUnescapedString(StringStream& is, size_t length) {
-    if (length < 16)
-        return RAPIDJSON_LIKELY(is.Tell() < length);
+inline bool Writer<StringBuffer>::WriteFloat(float f) {
+    if (internal::Double(static_cast<double>(f)).IsNanOrInf())
+        return WriteDouble(static_cast<double>(f));
 
-    if (!RAPIDJSON_LIKELY(is.Tell() < length))
-        return false;
-
-    const char* p = is.src_;
-    const char* end = is.head_ + length;
-    const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-    const char* endAligned = reinterpret_cast<const char*>(reinterpret_cast<size_t>(end) & static_cast<size_t>(~15));
-    if (nextAligned > end)
-        return true;
-
-    while (p != nextAligned)
-        if (*p < 0x20 || *p == '\"' || *p == '\\') {
-            is.src_ = p;
-            return RAPIDJSON_LIKELY(is.Tell() < length);
-        }
-        else
-            os_->PutUnsafe(*p++);
-
-    // The rest of string using SIMD
-    static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
-    static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-    static const char space[16]  = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
-    const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
-    const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
-    const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
-
-    for (; p != endAligned; p += 16) {
-        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-        const __m128i t1 = _mm_cmpeq_epi8(s, dq);
-        const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
-        const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
-        unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
-        if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
-            SizeType len;
-#ifdef _MSC_VER         // Find the index of first escaped
-            unsigned long offset;
-            _BitScanForward(&offset, r);
-            len = offset;
-#else
-            len = static_cast<SizeType>(__builtin_ffs(r) - 1);
-#endif
-            char* q = reinterpret_cast<char*>(os_->PushUnsafe(len));
-            for (size_t i = 0; i < len; i++)
-                q[i] = p[i];
-
-            p += len;
-            break;
-        }
-        _mm_storeu_si128(reinterpret_cast<__m128i *>(os_->PushUnsafe(16)), s);
-    }
-
-    is.src_ = p;
-    return RAPIDJSON_LIKELY(is.Tell() < length);
+    char *buffer = os_->Push(25);
+    char* end = internal::ftoa(f, buffer, maxDecimalPlaces_);
+    os_->Pop(static_cast<size_t>(25 - (end - buffer)));
+    return true;
 }
-#endif // defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
 
 RAPIDJSON_NAMESPACE_END
 
@@ -1,7 +1,27 @@
 #pragma once
 
 #include <string>
+#include <sstream>
+#include <algorithm>
 #include <vector>
+#include <memory>
+#include <deque>
+#include <functional>
+#include <exception>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+// define OFX_JSON_STATS to collect memory statistics (see ofxJsonDocument::getMemoryStats()).
+// NOTE: this changes the layout of rapidjson's allocator and stack, so it must be defined for the
+// whole project (e.g. ADDON_CFLAGS += -DOFX_JSON_STATS in addon_config.mk or the project's
+// preprocessor definitions), never in a single source file before including this header.
+#if defined(OFX_JSON_STATS) && !defined(RAPIDJSON_STATS)
+#define RAPIDJSON_STATS 1
+#endif
 
 #include "lib/rapidjson/document.h"
 #include "lib/rapidjson/error/error.h"
@@ -18,8 +38,400 @@
 #include "ofLog.h"
 #include "ofPoint.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <cerrno>
+#else
+#ifndef NOMINMAX
+#define NOMINMAX // keep std::min/std::max usable
+#endif
+#include <windows.h> // MoveFileExA()
+#endif
+
+// SIMD kernels of ofxJsonStructuralIndex (selected at runtime with RAPIDJSON_SIMD_DISPATCH)
+#if defined(__AVX2__) || defined(RAPIDJSON_SIMD_DISPATCH)
+#define OFX_JSON_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(RAPIDJSON_SIMD_DISPATCH)
+#define OFX_JSON_SSE2
+#endif
+#if defined(OFX_JSON_AVX2) || defined(OFX_JSON_SSE2)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace std;
 
+/*////////////////// ofxJsonBufferOStream //////////////*/
+
+/// output stream which writes directly into a string or ofBuffer (replacing its contents).
+/// the buffer is grown geometrically (reusing the memory it already has) and trimmed to the written
+/// data by finish(), so the serialized JSON doesn't need to be copied out of a temporary buffer.
+/// NOTE: implements rapidjson's Stream concept
+template<typename Buffer>
+class ofxJsonBufferOStream {
+public:
+    typedef char Ch;
+
+    static const size_t minCapacity = 256;
+
+    explicit ofxJsonBufferOStream(Buffer& buffer) : buffer_(buffer) { reset(); }
+    ofxJsonBufferOStream(const ofxJsonBufferOStream&) = delete;
+    ofxJsonBufferOStream& operator=(const ofxJsonBufferOStream&) = delete;
+
+    /// start over (keeps the memory of the buffer). the old contents are overwritten in place,
+    /// the spare capacity is only used (and zero-filled by resize()) when the data grows into it.
+    void reset();
+    /// trim the buffer to the written data
+    void finish();
+    const Ch* data() const { return begin_; }
+    size_t size() const { return current_ - begin_; }
+
+    void Put(Ch c) {
+        if (current_ == end_){
+            grow(1);
+        }
+        *current_++ = c;
+    }
+    void Flush() {}
+    /// make room for 'n' characters which are then written with putUnsafe()
+    void reserve(size_t n) {
+        if ((size_t)(end_ - current_) < n){
+            grow(n);
+        }
+    }
+    void putUnsafe(Ch c) { *current_++ = c; }
+    /// write 'n' characters at once
+    void write(const Ch* s, size_t n) {
+        reserve(n);
+        memcpy(current_, s, n);
+        current_ += n;
+    }
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    void grow(size_t n);
+    void update(size_t size);
+    static Ch* getData(string& s) { return &s[0]; }
+    static Ch* getData(ofBuffer& b) { return b.getData(); }
+    static size_t getCapacity(const string& s) { return s.capacity(); }
+    static size_t getCapacity(const ofBuffer& b) { return b.size(); }
+    Buffer& buffer_;
+    Ch* begin_;
+    Ch* current_;
+    Ch* end_;
+};
+
+typedef ofxJsonBufferOStream<string> ofxJsonStringOStream;
+
+/// output stream which writes into caller provided memory.
+/// characters which don't fit are only counted, so size() is the number of bytes needed.
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonMemoryOStream {
+public:
+    typedef char Ch;
+
+    ofxJsonMemoryOStream(Ch* data, size_t capacity)
+        : begin_(data), current_(data), end_(data + capacity), overflow_(0) {}
+
+    /// number of bytes written (or needed if the memory was too small)
+    size_t size() const { return (current_ - begin_) + overflow_; }
+    bool isFull() const { return overflow_ > 0; }
+
+    void Put(Ch c) {
+        if (current_ != end_){
+            *current_++ = c;
+        } else {
+            overflow_++;
+        }
+    }
+    void Flush() {}
+    /// write 'n' characters at once
+    void write(const Ch* s, size_t n) {
+        size_t count = std::min<size_t>(n, end_ - current_);
+        memcpy(current_, s, count);
+        current_ += count;
+        overflow_ += n - count;
+    }
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    Ch* begin_;
+    Ch* current_;
+    Ch* end_;
+    size_t overflow_;
+};
+
+/// output stream which only counts the characters (see ofxJsonDocument::serializedSize())
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonCountingOStream {
+public:
+    typedef char Ch;
+
+    ofxJsonCountingOStream() : count_(0) {}
+
+    size_t size() const { return count_; }
+    void add(size_t n) { count_ += n; }
+    /// number of decimal digits of 'u'
+    static size_t countDigits(uint64_t u) {
+        size_t n = 1;
+        for (; u >= 10000; u /= 10000) n += 4;
+        return n + (u >= 10) + (u >= 100) + (u >= 1000);
+    }
+
+    void Put(Ch) { count_++; }
+    void Flush() {}
+    void write(const Ch*, size_t n) { count_ += n; }
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    size_t count_;
+};
+
+RAPIDJSON_NAMESPACE_BEGIN
+/// let rapidjson's writer reserve room once and then copy characters without checks (like StringBuffer)
+template<> inline void PutReserve(ofxJsonBufferOStream<string>& os, size_t n) {
+    os.reserve(n);
+}
+template<> inline void PutUnsafe(ofxJsonBufferOStream<string>& os, char c) {
+    os.putUnsafe(c);
+}
+template<> inline void PutUnsafe(ofxJsonBufferOStream<string>& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+template<> inline void PutReserve(ofxJsonBufferOStream<ofBuffer>& os, size_t n) {
+    os.reserve(n);
+}
+template<> inline void PutUnsafe(ofxJsonBufferOStream<ofBuffer>& os, char c) {
+    os.putUnsafe(c);
+}
+template<> inline void PutUnsafe(ofxJsonBufferOStream<ofBuffer>& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+template<> inline void PutUnsafe(ofxJsonMemoryOStream& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+/// count runs and integers without copying or formatting them
+template<> inline void PutUnsafe(ofxJsonCountingOStream& os, const char*, size_t n) {
+    os.add(n);
+}
+template<> inline void PutN(ofxJsonCountingOStream& os, char, size_t n) {
+    os.add(n);
+}
+template<> inline bool Writer<ofxJsonCountingOStream>::WriteInt(int i) {
+    os_->add((i < 0) + ofxJsonCountingOStream::countDigits(i < 0 ? 0 - static_cast<uint64_t>(i) : i));
+    return true;
+}
+template<> inline bool Writer<ofxJsonCountingOStream>::WriteUint(unsigned u) {
+    os_->add(ofxJsonCountingOStream::countDigits(u));
+    return true;
+}
+template<> inline bool Writer<ofxJsonCountingOStream>::WriteInt64(int64_t i) {
+    os_->add((i < 0) + ofxJsonCountingOStream::countDigits(i < 0 ? 0 - static_cast<uint64_t>(i) : i));
+    return true;
+}
+template<> inline bool Writer<ofxJsonCountingOStream>::WriteUint64(uint64_t u) {
+    os_->add(ofxJsonCountingOStream::countDigits(u));
+    return true;
+}
+RAPIDJSON_NAMESPACE_END
+
+/// non-owning view of serialized JSON data
+struct ofxJsonBufferView {
+    ofxJsonBufferView() : data(nullptr), size(0) {}
+    ofxJsonBufferView(const char* data, size_t size) : data(data), size(size) {}
+
+    bool empty() const { return size == 0; }
+    string toString() const { return string(data, size); }
+
+    const char* data;
+    size_t size;
+};
+
+/*////////////////// ofxJsonSegmentedOStream //////////////*/
+
+class ofxJsonFileOStream;
+
+/// thread safe free list of fixed size chunks for ofxJsonSegmentedOStream
+class ofxJsonChunkPool {
+public:
+    static const size_t defaultChunkSize = 64 * 1024;
+
+    /// keeps at most 'maxFree' released chunks for reuse (64 MB by default).
+    /// reusing chunks avoids page faults, which cost more than the serialization itself for big documents.
+    ofxJsonChunkPool(size_t chunkSize = defaultChunkSize, size_t maxFree = 1024);
+    ofxJsonChunkPool(const ofxJsonChunkPool&) = delete;
+    ~ofxJsonChunkPool();
+    ofxJsonChunkPool& operator=(const ofxJsonChunkPool&) = delete;
+
+    size_t getChunkSize() const { return chunkSize_; }
+    char* allocate();
+    void release(char* chunk);
+    /// free the chunks kept for reuse
+    void trim();
+
+    static ofxJsonChunkPool& getDefault();
+protected:
+    size_t chunkSize_;
+    size_t maxFree_;
+    mutex mutex_;
+    vector<char*> free_;
+};
+
+/// output stream which appends fixed size chunks from an ofxJsonChunkPool instead of growing
+/// one contiguous buffer, so the data is never reallocated or moved.
+/// the chunks can be written to a file with a single writev() call (see writeTo()) or gathered with copyTo().
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonSegmentedOStream {
+public:
+    typedef char Ch;
+
+    /// 'pool' must outlive the stream
+    explicit ofxJsonSegmentedOStream(ofxJsonChunkPool& pool = ofxJsonChunkPool::getDefault());
+    ofxJsonSegmentedOStream(const ofxJsonSegmentedOStream&) = delete;
+    /// returns the chunks to the pool
+    ~ofxJsonSegmentedOStream();
+    ofxJsonSegmentedOStream& operator=(const ofxJsonSegmentedOStream&) = delete;
+
+    /// return the chunks to the pool and start over
+    void clear();
+    size_t size() const { return size_ + (current_ - begin_); }
+    size_t getNumSegments() const { return chunks_.size(); }
+    ofxJsonBufferView getSegment(size_t index) const;
+
+    /// gather the data into contiguous memory (at least size() bytes)
+    void copyTo(char* data) const;
+    void copyTo(string& buffer) const;
+    void copyTo(ofBuffer& buffer) const;
+    /// write all segments at once (with writev() on POSIX systems).
+    /// errors are reported by os.close().
+    void writeTo(ofxJsonFileOStream& os) const;
+#ifndef _WIN32
+    /// write all segments to a file descriptor (e.g. a socket or pipe) with writev()
+    bool writeTo(int fd) const;
+#endif
+
+    void Put(Ch c) {
+        if (current_ == end_){
+            addChunk();
+        }
+        *current_++ = c;
+    }
+    void Flush() {}
+    /// write 'n' characters at once (split across chunks)
+    void write(const Ch* s, size_t n);
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    void addChunk();
+    ofxJsonChunkPool& pool_;
+    vector<Ch*> chunks_; // all but the last one are full
+    size_t size_; // size of the full chunks
+    Ch* begin_;
+    Ch* current_;
+    Ch* end_;
+};
+
+RAPIDJSON_NAMESPACE_BEGIN
+/// NOTE: PutReserve() isn't specialized because the writer reserves up to 6 bytes per character
+/// for strings, which would waste whole chunks. every Put() checks for the end of the chunk instead.
+template<> inline void PutUnsafe(ofxJsonSegmentedOStream& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+RAPIDJSON_NAMESPACE_END
+
+/// output stream which forwards to either a string stream or a segmented stream,
+/// so ofxPrettyJsonWriter needs only one rapidjson writer for both outputs.
+/// the target is fixed between resets, so the branch in Put() is always predicted.
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonForwardingOStream {
+public:
+    typedef char Ch;
+
+    ofxJsonForwardingOStream() : string_(nullptr), segmented_(nullptr) {}
+
+    void setTarget(ofxJsonStringOStream& os) { string_ = &os; segmented_ = nullptr; }
+    void setTarget(ofxJsonSegmentedOStream& os) { string_ = nullptr; segmented_ = &os; }
+    ofxJsonSegmentedOStream* getSegmented() const { return segmented_; }
+
+    void Put(Ch c) {
+        if (segmented_){
+            segmented_->Put(c);
+        } else {
+            string_->Put(c);
+        }
+    }
+    void Flush() {}
+    /// see ofxJsonBufferOStream::reserve(). segmented streams check every Put() instead.
+    void reserve(size_t n) {
+        if (!segmented_){
+            string_->reserve(n);
+        }
+    }
+    void putUnsafe(Ch c) {
+        if (segmented_){
+            segmented_->Put(c);
+        } else {
+            string_->putUnsafe(c);
+        }
+    }
+    void write(const Ch* s, size_t n) {
+        if (segmented_){
+            segmented_->write(s, n);
+        } else {
+            string_->write(s, n);
+        }
+    }
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    ofxJsonStringOStream* string_;
+    ofxJsonSegmentedOStream* segmented_;
+};
+
+RAPIDJSON_NAMESPACE_BEGIN
+template<> inline void PutReserve(ofxJsonForwardingOStream& os, size_t n) {
+    os.reserve(n);
+}
+template<> inline void PutUnsafe(ofxJsonForwardingOStream& os, char c) {
+    os.putUnsafe(c);
+}
+template<> inline void PutUnsafe(ofxJsonForwardingOStream& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+RAPIDJSON_NAMESPACE_END
+
 /*////////////////// ofxPrettyJsonWriter //////////////*/
 
 class ofxPrettyJsonWriter {
@@ -33,9 +445,26 @@ public:
     ofxPrettyJsonWriter& operator<<(T&& val);
 
     void reset();
+    /// write into 'output' instead of the internal buffer (e.g. to send it with ofxJsonSegmentedOStream::writeTo()).
+    /// saveToBuffer(), saveToView() and takeBuffer() don't apply until the next reset().
+    void reset(ofxJsonSegmentedOStream& output);
+    /// copy the JSON data
     bool saveToBuffer(string& buffer);
     bool saveToBuffer(ofBuffer& buffer);
-    bool saveToFile(const string& path);
+    /// view of the JSON data without copying it (valid until the writer is modified or reset).
+    /// returns an empty view if the JSON is not complete.
+    ofxJsonBufferView saveToView() const;
+    /// move the JSON data into 'buffer' without copying it.
+    /// the writer has to be reset() before it can be used again.
+    bool takeBuffer(string& buffer);
+    /// see ofxJsonDocument::saveToFile()
+    bool saveToFile(const string& path, bool atomic = false);
+
+    /// write numbers with at most 'places' decimal places (e.g. 3: 0.12345 -> 0.123).
+    /// floats are always written with their shortest round-trip representation,
+    /// so only set this if you need to truncate further. pass 'ofxJsonDefaultMaxDecimalPlaces' to reset.
+    ofxPrettyJsonWriter& setMaxDecimalPlaces(int places);
+    int getMaxDecimalPlaces() const;
 
     ofxPrettyJsonWriter& startObject();
     ofxPrettyJsonWriter& endObject();
@@ -52,8 +481,11 @@ public:
     template<typename T>
     ofxPrettyJsonWriter& addObject(const unordered_map<string, T>& map);
 protected:
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer_;
-    rapidjson::StringBuffer buffer_;
+    string buffer_;
+    ofxJsonStringOStream stream_{buffer_};
+    ofxJsonForwardingOStream output_; // 'stream_' or the segmented output (see reset(ofxJsonSegmentedOStream&))
+    rapidjson::PrettyWriter<ofxJsonForwardingOStream> writer_;
+    bool isComplete() const;
     void doAdd(uint32_t n);
     void doAdd(int32_t n);
     void doAdd(uint64_t n);
@@ -70,7 +502,87 @@ protected:
     void doAdd(const unordered_map<string, T>& map);
 };
 
+/// no truncation of decimal places (see setMaxDecimalPlaces())
+const int ofxJsonDefaultMaxDecimalPlaces = rapidjson::Writer<rapidjson::StringBuffer>::kDefaultMaxDecimalPlaces;
+/// chunk size of the memory pool of a document (same as rapidjson's default)
+const size_t ofxJsonDefaultChunkSize = 64 * 1024;
+/// allocates the chunks of the memory pool of a document (see ofxJsonDocument constructors).
+/// implement Malloc() and Free() to plug in a custom allocator.
+typedef rapidjson::ChunkAllocator ofxJsonBaseAllocator;
+
+/*///////////// ofxJsonThreadCachingAllocator ////////////////*/
+
+/// base allocator which keeps freed chunks in per-thread free lists, so threads which create
+/// and destroy documents at the same time don't contend for the heap.
+/// chunks of up to 'chunkSize' bytes come from the free lists, so give the documents the same chunk size:
+///     ofxJsonDocument doc(ofxJsonDefaultChunkSize, &ofxJsonThreadCachingAllocator::getDefault());
+/// bigger chunks come from the heap, or - from 'hugePageThreshold' bytes on - from 2 MB huge pages
+/// (madvise(MADV_HUGEPAGE), Linux only; 0 = never), which saves TLB misses for very large documents.
+/// chunks freed on another thread go to that thread's list; surplus chunks are shared through a central depot.
+/// thread safe. NOTE: must outlive the documents using it.
+class ofxJsonThreadCachingAllocator : public ofxJsonBaseAllocator {
+public:
+    static const size_t hugePageSize = 2 * 1024 * 1024;
+    /// document chunk size which fills whole huge pages
+    static const size_t hugePageChunkSize = hugePageSize - 64;
+
+    /// every thread keeps up to 'maxCached' free chunks, the depot up to 'maxShared'.
+    ofxJsonThreadCachingAllocator(size_t chunkSize = ofxJsonDefaultChunkSize, size_t maxCached = 32,
+                                  size_t maxShared = 256, size_t hugePageThreshold = 0);
+    ofxJsonThreadCachingAllocator(const ofxJsonThreadCachingAllocator&) = delete;
+    /// NOTE: chunks cached by threads are only freed when these threads exit (or call trim())
+    ~ofxJsonThreadCachingAllocator();
+    ofxJsonThreadCachingAllocator& operator=(const ofxJsonThreadCachingAllocator&) = delete;
+
+    void* Malloc(size_t size) override;
+    void Free(void* ptr, size_t size) override;
+    /// free the chunks in the depot and in the list of the calling thread
+    void trim();
+
+    size_t getChunkSize() const { return blockSize_ - headerSize; }
+
+    static ofxJsonThreadCachingAllocator& getDefault();
+protected:
+    struct ThreadCache;
+    vector<void*>* getCache(); // nullptr while the thread exits
+    static void* allocateHugePages(size_t size);
+    static void freeHugePages(void* ptr, size_t size);
+    static const size_t headerSize = 64; // room for the header of a pool chunk
+    size_t blockSize_;
+    size_t maxCached_;
+    size_t maxShared_;
+    size_t hugePageThreshold_;
+    uint64_t id_; // identifies the lists of this allocator in the thread caches
+    mutex mutex_;
+    vector<void*> shared_;
+};
+
+/*///////////// ofxJsonMemoryStats ////////////////*/
+
+/// memory usage of a document (see ofxJsonDocument::getMemoryStats()).
+/// the fields marked with (*) are only collected if OFX_JSON_STATS is defined,
+/// otherwise they stay 0 and the counters aren't compiled at all.
+/// the other fields are computed on demand by walking the chunks of the memory pool.
+struct ofxJsonMemoryStats {
+    bool enabled = false; // OFX_JSON_STATS is defined
+    size_t numChunks = 0; // chunks of the memory pool in use (including a user buffer)
+    size_t capacity = 0; // bytes in these chunks
+    size_t numRecycledChunks = 0; // chunks kept for reuse (see ofxJsonDocument::setRecycleMode())
+    size_t recycledCapacity = 0;
+    size_t size = 0; // bytes handed out to values and strings since the last load or clear()
+    size_t bytesRequested = 0; // (*) bytes asked for by values and strings (reallocations count again)
+    size_t bytesWasted = 0; // (*) alignment, unused rest of full chunks and blocks left behind by reallocation
+    size_t peakSize = 0; // (*) maximum of 'size'
+    size_t stackHighWater = 0; // (*) maximum bytes on the parse stack (values under construction)
+    size_t readerStackHighWater = 0; // (*) maximum bytes on the stack for decoding strings
+};
+
 class ofxJsonDocument;
+class ofxJsonLoadHandle;
+struct ofxJsonLoadState;
+class ofxJsonSaveHandle;
+struct ofxJsonSaveQueue;
+class ofxJsonLazyDocument;
 class ofxJsonValueRef;
 class ofxJsonArrayRef;
 class ofxJsonObjectRef;
@@ -134,11 +646,380 @@ using ofxJsonValueIterator = ofxJsonIterator<rapidjson::Value::ValueIterator, of
 using ofxJsonMemberIterator = ofxJsonIterator<rapidjson::Value::MemberIterator, ofxJsonMemberRef, rapidjson::Document::AllocatorType>;
 
 
+/*///////////// ofxJsonMappedFile ////////////////*/
+
+/// a file mapped privately (copy-on-write) into memory.
+/// the data is always followed by at least one zero byte, so it can be parsed in-situ.
+/// memory mapping is not available on Windows, open() will simply fail there.
+class ofxJsonMappedFile {
+public:
+    ofxJsonMappedFile();
+    ofxJsonMappedFile(const ofxJsonMappedFile&) = delete;
+    ~ofxJsonMappedFile();
+    ofxJsonMappedFile& operator=(const ofxJsonMappedFile&) = delete;
+
+    /// map the file. fails for files which can't be mapped (e.g. pipes).
+    bool open(const string& path);
+    void close();
+    bool isOpen() const;
+    /// mutable pointer to the (zero terminated) file contents
+    char* getData();
+    /// file size in bytes (excluding the zero terminator)
+    size_t size() const;
+protected:
+    char* data_;
+    size_t size_;
+    size_t mappedSize_;
+};
+
+/*///////////// ofxJsonBufferedIStream ////////////////*/
+
+/// rapidjson input stream which reads a std::istream in large blocks
+/// (like rapidjson::FileReadStream) instead of character by character (like rapidjson::IStreamWrapper).
+/// whitespace is skipped block-wise (with SIMD if enabled).
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonBufferedIStream {
+public:
+    typedef char Ch;
+
+    static const size_t defaultBufferSize = 64 * 1024;
+
+    ofxJsonBufferedIStream(istream& is, size_t bufferSize = defaultBufferSize);
+    ofxJsonBufferedIStream(const ofxJsonBufferedIStream&) = delete;
+    ~ofxJsonBufferedIStream();
+    ofxJsonBufferedIStream& operator=(const ofxJsonBufferedIStream&) = delete;
+
+    Ch Peek() const { return *current_; }
+    Ch Take() { Ch c = *current_; read(); return c; }
+    size_t Tell() const { return count_ + static_cast<size_t>(current_ - buffer_.data()); }
+
+    // not implemented
+    void Put(Ch) { RAPIDJSON_ASSERT(false); }
+    void Flush() { RAPIDJSON_ASSERT(false); }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+
+    // for encoding detection only
+    const Ch* Peek4() const { return (current_ + 4 <= bufferLast_) ? current_ : 0; }
+
+    /// skip whitespace inside the current block, refill as needed
+    void skipWhitespace();
+
+    /// keep all data from the current position in memory (the buffer grows as needed),
+    /// so that rewind() can go back to it, e.g. to resynchronize after a parse error.
+    void mark();
+    void unmark();
+    /// go back to the mark
+    void rewind();
+protected:
+    void read();
+    istream& is_;
+    vector<Ch> buffer_;
+    size_t blockSize_;
+    Ch* bufferLast_;
+    Ch* current_;
+    Ch* mark_;
+    size_t readCount_; // number of characters in the buffer
+    size_t count_; // number of characters before the buffer
+    bool eof_;
+};
+
+RAPIDJSON_NAMESPACE_BEGIN
+/// let rapidjson's reader skip whitespace block-wise
+template<> inline void SkipWhitespace(ofxJsonBufferedIStream& is) {
+    is.skipWhitespace();
+}
+RAPIDJSON_NAMESPACE_END
+
+/*///////////// ofxJsonFileOStream ////////////////*/
+
+/// rapidjson output stream which writes a file in large blocks with write()/writev()
+/// (like rapidjson::FileWriteStream) instead of character by character (like rapidjson::OStreamWrapper).
+/// long runs of characters (e.g. strings) aren't copied into the block but written together with it.
+///
+/// with 'atomic' the data is written to a temporary file next to 'path', which is synced to disk
+/// and then renamed to 'path' by close(). readers never see a half written file and
+/// a crash leaves the previous file intact. the permissions of the previous file are kept.
+/// NOTE: implements rapidjson's Stream concept
+class ofxJsonFileOStream {
+public:
+    typedef char Ch;
+
+    static const size_t defaultBufferSize = 1024 * 1024;
+
+    ofxJsonFileOStream(size_t bufferSize = defaultBufferSize);
+    ofxJsonFileOStream(const ofxJsonFileOStream&) = delete;
+    /// an atomic file which hasn't been closed is discarded
+    ~ofxJsonFileOStream();
+    ofxJsonFileOStream& operator=(const ofxJsonFileOStream&) = delete;
+
+    bool open(const string& path, bool atomic = false);
+    /// write the remaining data and close the file.
+    /// returns false if any write failed (an atomic file then doesn't replace 'path').
+    bool close();
+    /// close the file without keeping it (an atomic file doesn't replace 'path')
+    void discard();
+    bool isOpen() const;
+    /// number of bytes written so far (including the current block)
+    size_t size() const;
+
+    void Put(Ch c) {
+        if (current_ == bufferEnd_){
+            Flush();
+        }
+        *current_++ = c;
+    }
+    void Flush();
+    /// write 'n' characters at once
+    void write(const Ch* s, size_t n);
+    /// write several runs of characters at once (after the current block).
+    /// on POSIX systems they are gathered with writev() instead of being copied into the block.
+    void write(const ofxJsonBufferView* runs, size_t count);
+#ifndef _WIN32
+    /// write all 'iov' to 'fd', retrying partial writes. returns false on error.
+    static bool writeAll(int fd, struct iovec* iov, size_t count);
+#endif
+
+    // not implemented
+    Ch Peek() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch Take() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t Tell() const { RAPIDJSON_ASSERT(false); return 0; }
+    Ch* PutBegin() { RAPIDJSON_ASSERT(false); return 0; }
+    size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+protected:
+    void writeBlocks(const Ch* s, size_t n);
+    vector<Ch> buffer_;
+    Ch* current_;
+    Ch* bufferEnd_;
+    size_t count_; // number of bytes in previous blocks
+#ifndef _WIN32
+    int fd_;
+#else
+    ofstream file_;
+#endif
+    string path_;
+    string tempPath_; // empty if not atomic
+    bool error_;
+};
+
+RAPIDJSON_NAMESPACE_BEGIN
+/// let rapidjson's writer copy unescaped strings in one go
+template<> inline void PutUnsafe(ofxJsonFileOStream& os, const char* s, size_t n) {
+    os.write(s, n);
+}
+RAPIDJSON_NAMESPACE_END
+
+/*///////////// ofxJsonThreadPool ////////////////*/
+
+/// work-stealing pool of worker threads for background parsing/serializing.
+/// every worker has its own task queue; idle workers steal from the others.
+/// queued tasks are still executed when the pool is destroyed.
+class ofxJsonThreadPool {
+public:
+    /// numThreads = 0 -> one thread per core
+    ofxJsonThreadPool(size_t numThreads = 0);
+    ofxJsonThreadPool(const ofxJsonThreadPool&) = delete;
+    ~ofxJsonThreadPool();
+    ofxJsonThreadPool& operator=(const ofxJsonThreadPool&) = delete;
+
+    /// tasks pushed from a worker go to its own queue, others are distributed round-robin
+    void push(function<void()> task);
+    size_t getNumThreads() const;
+    /// run one queued task on the calling thread, returns false if the queues are empty.
+    /// threads which wait for tasks of this pool should help out with this, so that waiting
+    /// on a worker thread can't deadlock the pool.
+    bool runPendingTask();
+    /// is the calling thread one of our workers?
+    bool isWorkerThread() const;
+
+    /// pool shared by all asynchronous operations (unless specified otherwise)
+    static ofxJsonThreadPool& getDefault();
+protected:
+    struct Queue {
+        mutex mtx;
+        deque<function<void()>> tasks;
+    };
+    struct WorkerInfo {
+        const ofxJsonThreadPool* pool;
+        size_t index;
+    };
+    static WorkerInfo& getWorkerInfo(); // of the calling thread
+    bool pop(size_t index, function<void()>& task);
+    void run(size_t index);
+    vector<unique_ptr<Queue>> queues_;
+    vector<thread> threads_;
+    atomic<size_t> next_;
+    mutex mutex_;
+    condition_variable condition_;
+    size_t pending_; // number of queued tasks (protected by mutex_)
+    bool quit_;
+};
+
+/*///////////// ofxJsonProgressHandler ////////////////*/
+
+/// SAX handler which forwards all events to a document, periodically publishes the number of
+/// consumed bytes and stops the parser (kParseErrorTermination) once 'cancel' is set.
+/// NOTE: progress is taken from the handler and not from a stream wrapper, so the reader still sees the
+/// original stream type and keeps its fast paths (SkipWhitespace, ParseNumberFast, ...)
+template<typename InputStream>
+class ofxJsonProgressHandler {
+public:
+    typedef char Ch;
+
+    static const size_t updateInterval = 4096; // events
+
+    ofxJsonProgressHandler(rapidjson::Document& doc, const InputStream& is,
+                           atomic<size_t>& bytesConsumed, const atomic<bool>& cancel)
+        : doc_(doc), is_(is), bytesConsumed_(bytesConsumed), cancel_(cancel), countdown_(updateInterval), stopped_(false) {}
+
+    bool Null() { return doc_.Null() && next(); }
+    bool Bool(bool b) { return doc_.Bool(b) && next(); }
+    bool Int(int i) { return doc_.Int(i) && next(); }
+    bool Uint(unsigned i) { return doc_.Uint(i) && next(); }
+    bool Int64(int64_t i) { return doc_.Int64(i) && next(); }
+    bool Uint64(uint64_t i) { return doc_.Uint64(i) && next(); }
+    bool Double(double d) { return doc_.Double(d) && next(); }
+    bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return doc_.RawNumber(str, length, copy) && next(); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool copy) { return doc_.String(str, length, copy) && next(); }
+    bool StartObject() { return doc_.StartObject() && next(); }
+    bool Key(const Ch* str, rapidjson::SizeType length, bool copy) { return doc_.Key(str, length, copy) && next(); }
+    bool EndObject(rapidjson::SizeType memberCount) { return doc_.EndObject(memberCount) && next(); }
+    bool StartArray() { return doc_.StartArray() && next(); }
+    bool EndArray(rapidjson::SizeType elementCount) { return doc_.EndArray(elementCount) && next(); }
+
+    /// publish the current position
+    void update() {
+        bytesConsumed_.store(is_.Tell(), memory_order_relaxed);
+        stopped_ = cancel_.load(memory_order_relaxed);
+        countdown_ = updateInterval;
+    }
+    bool isStopped() const { return stopped_; }
+protected:
+    bool next() {
+        if (--countdown_ == 0){
+            update();
+        }
+        return !stopped_;
+    }
+    rapidjson::Document& doc_;
+    const InputStream& is_;
+    atomic<size_t>& bytesConsumed_;
+    const atomic<bool>& cancel_;
+    size_t countdown_;
+    bool stopped_;
+};
+
+/*///////////// ofxJsonSimdLevel ////////////////*/
+
+/// SIMD code paths of the reader, the writer and ofxJsonStructuralIndex.
+/// with RAPIDJSON_SIMD_DISPATCH (the default on x86) the best level supported by the CPU is selected at runtime,
+/// otherwise it is fixed at compile time (RAPIDJSON_SSE2, RAPIDJSON_SSE42).
+enum ofxJsonSimdLevel {
+    OFX_JSON_SIMD_SCALAR = rapidjson::internal::kSimdScalar,
+    OFX_JSON_SIMD_SSE2 = rapidjson::internal::kSimdSSE2,
+    OFX_JSON_SIMD_SSE42 = rapidjson::internal::kSimdSSE42,
+    OFX_JSON_SIMD_AVX2 = rapidjson::internal::kSimdAVX2
+};
+
+ofxJsonSimdLevel ofxJsonGetSimdLevel();
+ofxJsonSimdLevel ofxJsonGetSupportedSimdLevel();
+/// force a lower level, e.g. to compare the code paths in tests and benchmarks.
+/// only possible with RAPIDJSON_SIMD_DISPATCH. may be called while other threads are parsing/writing
+/// (they switch at the next scan).
+/// returns false if the level isn't supported.
+bool ofxJsonSetSimdLevel(ofxJsonSimdLevel level);
+/// "scalar", "SSE2", "SSE4.2" or "AVX2"
+const char* ofxJsonGetSimdLevelName(ofxJsonSimdLevel level);
+
+/*///////////// ofxJsonStructuralIndex ////////////////*/
+
+enum ofxJsonParseMode {
+    OFX_JSON_PARSE_DEFAULT, // rapidjson's recursive descent parser
+    OFX_JSON_PARSE_INDEXED  // ofxJsonStructuralIndex
+};
+
+/// two stage parser (like simdjson):
+/// build() finds all quotes, structural characters ({}[]:,) and the beginnings of other values
+/// 64 bytes at a time (with AVX2 or SSE2, see ofxJsonSimdLevel) and stores their positions.
+/// parse() walks the positions and sends the events to a rapidjson handler, e.g. a rapidjson::Document.
+class ofxJsonStructuralIndex {
+public:
+    /// positions are stored as 32 bit integers
+    static const size_t maxSize = 0xffffffff;
+
+    ofxJsonStructuralIndex();
+
+    /// build the index. fails for unterminated strings and control characters within strings.
+    /// NOTE: the data is not copied and must stay alive until parse() has returned
+    bool build(const char* data, size_t size);
+    /// like build(), but passes every position to 'callback' instead of storing it (no size limit).
+    /// if the callback returns false, scanning stops with kParseErrorTermination.
+    template<typename Callback>
+    bool scan(const char* data, size_t size, Callback&& callback);
+    /// walk the index and validate the grammar
+    template<typename Handler>
+    bool parse(Handler& handler);
+
+    const vector<uint32_t>& getPositions() const;
+    rapidjson::ParseErrorCode getError() const;
+    size_t getErrorOffset() const;
+    /// the kernel used by build(): "AVX2", "SSE2" or "scalar"
+    static const char* getKernelName();
+protected:
+    struct Masks {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;
+        uint64_t whitespace;
+        uint64_t control;
+    };
+    template<typename Handler>
+    struct KeyHandler;
+    typedef void (*FindMasksFunction)(const char* block, Masks& masks);
+    static FindMasksFunction getFindMasks();
+#ifdef OFX_JSON_AVX2
+    RAPIDJSON_TARGET("avx2") static void findMasksAVX2(const char* block, Masks& masks);
+#endif
+#ifdef OFX_JSON_SSE2
+    RAPIDJSON_TARGET("sse2") static void findMasksSSE2(const char* block, Masks& masks);
+#endif
+    static void findMasksScalar(const char* block, Masks& masks);
+    static uint64_t findEscaped(uint64_t backslash, uint64_t& prevEscaped);
+    static uint64_t prefixXor(uint64_t bits);
+    static int countTrailingZeros(uint64_t bits);
+    template<typename Handler>
+    bool parseString(Handler& handler, size_t index, bool isKey);
+    template<typename Handler>
+    bool parseScalar(Handler& handler, size_t index);
+    template<typename Handler>
+    static bool parseInteger(Handler& handler, const char* str, size_t length, bool& result);
+    bool setError(rapidjson::ParseErrorCode error, size_t offset);
+
+    const char* data_;
+    size_t size_;
+    vector<uint32_t> positions_;
+    rapidjson::Reader reader_; // for numbers and escaped strings
+    rapidjson::ParseErrorCode error_;
+    size_t errorOffset_;
+};
+
 /*///////////// ofxJsonDocument ////////////////*/
 
 class ofxJsonDocument {
+    friend class ofxJsonLinesReader;
+    friend class ofxJsonLazyDocument;
 public:
     ofxJsonDocument();
+    /// use chunks of 'chunkSize' bytes for the memory pool of the document.
+    /// the chunks are allocated by 'baseAllocator' if given (it must outlive the document).
+    explicit ofxJsonDocument(size_t chunkSize, ofxJsonBaseAllocator* baseAllocator = nullptr);
+    /// use caller owned memory (e.g. a stack buffer or a preallocated slab) for the document.
+    /// the allocator, the parse stack (1/8 of the buffer) and the first chunk of the memory pool
+    /// are placed in 'buffer', so small documents never touch the heap.
+    /// only when it's full, further chunks of 'chunkSize' bytes are allocated.
+    /// 'buffer' must outlive the document (or the document it's moved to); copies use the heap again.
+    ofxJsonDocument(void* buffer, size_t size, size_t chunkSize = ofxJsonDefaultChunkSize,
+                    ofxJsonBaseAllocator* baseAllocator = nullptr);
     ofxJsonDocument(const ofxJsonDocument& mom);
     ofxJsonDocument(ofxJsonDocument&& mom);
     ~ofxJsonDocument();
@@ -147,16 +1028,92 @@ public:
     ofxJsonDocument& operator =(ofxJsonDocument&& mom);
 
     /// load JSON data
-    bool loadFromFile(const string& path);
-    bool loadFromBuffer(const string& buffer);
-    bool loadFromBuffer(const ofBuffer& buffer);
-
-    /// save JSON data
-    bool saveToFile(const string& path, bool pretty = true);
+    bool loadFromFile(const string& path, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    /// load JSON data from a memory mapped file and parse it in-situ,
+    /// so strings point directly into the mapped pages instead of being copied.
+    /// the mapping stays alive as long as the document (or any copy of it) does.
+    /// falls back to loadFromFile() if the file can't be mapped.
+    ///
+    /// NOTE: copying single values into *another* document (e.g. via ofxJsonValueRef)
+    /// doesn't copy their strings, so the other document must not outlive this one.
+    bool loadFromFileMapped(const string& path);
+    /// OFX_JSON_PARSE_INDEXED uses ofxJsonStructuralIndex (falls back to the default parser for buffers >= 4 GB)
+    bool loadFromBuffer(const string& buffer, ofxJsonParseMode mode = OFX_JSON_PARSE_DEFAULT);
+    bool loadFromBuffer(const ofBuffer& buffer, ofxJsonParseMode mode = OFX_JSON_PARSE_DEFAULT);
+    /// read from any std::istream (including pipes) in blocks of 'bufferSize' bytes
+    bool loadFromStream(istream& is, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+
+    /// load JSON data on a worker thread.
+    /// the returned handle reports the progress and hands over the finished document.
+    static ofxJsonLoadHandle loadFromFileAsync(const string& path, ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+    /// the buffer is moved (or copied) to the worker thread
+    static ofxJsonLoadHandle loadFromBufferAsync(string buffer, ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+    static ofxJsonLoadHandle loadFromBufferAsync(const ofBuffer& buffer, ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+
+    /// load many files concurrently (one task per file).
+    /// 'documents' and 'errors' get the same size and order as 'paths';
+    /// the error string is empty for every file which has been loaded successfully.
+    /// returns true if all files could be loaded.
+    /// the calling thread runs queued tasks of 'pool' while waiting, so this may also be called from a worker thread.
+    static bool loadFromFiles(const vector<string>& paths, vector<ofxJsonDocument>& documents, vector<string>& errors,
+                              ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+
+    /// save JSON data.
+    /// with 'atomic', the file is replaced only after it has been written completely (see ofxJsonFileOStream)
+    bool saveToFile(const string& path, bool pretty = true, bool atomic = false);
+    /// the JSON data is written directly into 'buffer' (no intermediate copy).
+    /// the memory 'buffer' already has is reused; afterwards it may have more capacity than it needs.
+    /// the old contents are overwritten while writing, so on failure (e.g. NaN values) 'buffer' is cleared.
     bool saveToBuffer(string& buffer, bool pretty = true);
     bool saveToBuffer(ofBuffer& buffer, bool pretty = true);
-    /// clear document
+    /// write into caller provided memory. 'size' is set to the size of the JSON data.
+    /// returns false if it doesn't fit into 'capacity' bytes; 'size' is then the capacity needed.
+    /// if the document can't be serialized at all (e.g. NaN values) it returns false with 'size' = 0.
+    bool saveToBuffer(char* data, size_t capacity, size_t& size, bool pretty = true);
+    /// append to a segmented buffer (no reallocation, see ofxJsonSegmentedOStream)
+    bool saveToBuffer(ofxJsonSegmentedOStream& buffer, bool pretty = true);
+    /// save into an internal buffer which is reused by the next call.
+    /// the view is valid until the next call or until the document is destroyed.
+    /// returns an empty view on failure.
+    ofxJsonBufferView saveToView(bool pretty = true);
+    /// exact number of bytes saveToBuffer()/saveToFile() will write, without writing anything.
+    /// use it to allocate the destination once and then fill it with saveToBuffer(data, capacity, size).
+    /// returns 0 if the document can't be serialized (e.g. NaN values), valid JSON is never empty.
+    size_t serializedSize(bool pretty = true) const;
+
+    /// save JSON data on a worker thread.
+    /// only a deep copy of the document is made on the calling thread, so the document
+    /// can be modified right after the call. saves to the same path which are still waiting
+    /// for the worker are coalesced: only the most recent snapshot is written.
+    /// the returned handle reports the result, the latency and the number of bytes written.
+    /// NOTE: the snapshot is a full deep copy, so for large documents the calling thread still pays
+    /// a good part (roughly half) of a synchronous save. check getSnapshotTime() of the handle.
+    ofxJsonSaveHandle saveToFileAsync(const string& path, bool pretty = true, bool atomic = false,
+                                      ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+
+    /// truncate numbers to at most 'places' decimal places when saving (see ofxPrettyJsonWriter::setMaxDecimalPlaces())
+    void setMaxDecimalPlaces(int places);
+    int getMaxDecimalPlaces() const;
+    /// recycle mode for documents which load many messages one after another:
+    /// every load (and clear()) drops the previous values but keeps the chunks of the memory pool
+    /// and the capacity of the parse stacks, so a steady stream of messages doesn't allocate at all.
+    /// NOTE: values and strings of the previous load become invalid (a failed load leaves a null document),
+    /// so the data to load must not point into the document itself.
+    void setRecycleMode(bool recycle);
+    bool getRecycleMode() const;
+    /// clear document (in recycle mode the memory is kept for the next load)
     void clear();
+    /// memory usage of the document (see ofxJsonMemoryStats).
+    /// use getRoot().getFootprint() or the footprint of any other value for a per-subtree estimate.
+    ofxJsonMemoryStats getMemoryStats() const;
+    /// start new measurements of the peak size and of the stack high-water marks
+    void resetMemoryStats();
+    /// rebuild the values in depth-first order into fresh memory, so the elements and strings
+    /// of every container lie next to each other, and free the old chunks of the memory pool.
+    /// this gives back what edits leave behind (erased members, overwritten strings, grown arrays)
+    /// as well as unused array and object capacity. returns the number of bytes reclaimed.
+    /// NOTE: invalidates all value references, iterators and string pointers into the document.
+    size_t compact();
     /// does a key exist?
     /// return an ofxJsonValueIterator to the found Value
     /// or to document.end() if it doesn't exist.
@@ -179,10 +1136,480 @@ public:
     rapidjson::Document& getDocument();
 //    const rapidjson::Document& getDocument() const;
 protected:
+    typedef rapidjson::MemoryPoolAllocator<> Allocator;
+    Allocator* allocator_; // created for the constructor options, otherwise owned by document_
+    bool allocatorInBuffer_; // placed in the buffer of the user
     rapidjson::Document document_;
+    shared_ptr<ofxJsonMappedFile> mappedFile_; // keeps in-situ parsed strings alive
+    int maxDecimalPlaces_ = ofxJsonDefaultMaxDecimalPlaces;
+    shared_ptr<ofxJsonSaveQueue> saveQueue_; // created by the first saveToFileAsync()
+    string saveBuffer_; // for saveToView()
+    bool recycle_ = false;
     void printError(rapidjson::ParseErrorCode error, size_t offset);  
-    bool loadFromBuffer(const char* data, size_t size);
-    bool saveToBuffer(rapidjson::StringBuffer&, bool pretty);
+    static Allocator* createAllocator(void* buffer, size_t size, size_t chunkSize, bool& inBuffer);
+    void destroyAllocator();
+    bool loadFromBuffer(const char* data, size_t size, ofxJsonParseMode mode = OFX_JSON_PARSE_DEFAULT);
+    template<typename OutputStream>
+    bool write(OutputStream& os, bool pretty) const;
+    static void saveAsync(ofxJsonSaveQueue& queue);
+    template<typename InputStream>
+    static void loadAsync(ofxJsonLoadState& state, InputStream& is);
+    static string loadFromFileBatched(ofxJsonDocument& document, const string& path);
+};
+
+/*///////////// ofxJsonDocumentPool ////////////////////////////*/
+
+/// thread safe pool of documents in recycle mode (see ofxJsonDocument::setRecycleMode()).
+/// released documents keep their memory, so processing messages with acquire() -> load -> release
+/// doesn't allocate anything once the pool is warm.
+class ofxJsonDocumentPool {
+public:
+    struct Deleter {
+        ofxJsonDocumentPool* pool;
+        void operator()(ofxJsonDocument* document) const { pool->release(document); }
+    };
+    /// releases the document to its pool when it goes out of scope
+    typedef unique_ptr<ofxJsonDocument, Deleter> Ptr;
+
+    /// keeps at most 'maxFree' released documents for reuse.
+    /// new documents use chunks of 'chunkSize' bytes for their memory pool.
+    ofxJsonDocumentPool(size_t maxFree = 64, size_t chunkSize = ofxJsonDefaultChunkSize);
+    ofxJsonDocumentPool(const ofxJsonDocumentPool&) = delete;
+    /// NOTE: all documents must have been released
+    ~ofxJsonDocumentPool();
+    ofxJsonDocumentPool& operator=(const ofxJsonDocumentPool&) = delete;
+
+    /// get an empty document (a released one if possible)
+    Ptr acquire();
+    /// clear the document and keep it for reuse (called by Ptr)
+    void release(ofxJsonDocument* document);
+    /// free the documents kept for reuse
+    void trim();
+
+    static ofxJsonDocumentPool& getDefault();
+protected:
+    size_t maxFree_;
+    size_t chunkSize_;
+    mutex mutex_;
+    vector<ofxJsonDocument*> free_;
+};
+
+/*///////////// ofxJsonLoadHandle ////////////////////////////*/
+
+/// state shared between an ofxJsonLoadHandle and its worker (internal)
+struct ofxJsonLoadState {
+    ofxJsonDocument document;
+    ofxJsonThreadPool* pool = nullptr;
+    atomic<size_t> bytesConsumed{0};
+    atomic<size_t> bytesTotal{0};
+    atomic<bool> cancelled{false};
+    mutable mutex mtx;
+    mutable condition_variable condition;
+    bool done = false;
+    bool result = false;
+    string error;
+    void finish(bool result, const string& error);
+};
+
+/// future-like handle for an asynchronous load operation.
+/// all methods may be called from the owning thread while the worker is parsing.
+/// a default constructed (invalid) handle behaves like a failed operation which has already finished.
+class ofxJsonLoadHandle {
+    friend class ofxJsonDocument;
+public:
+    ofxJsonLoadHandle() {} // invalid handle
+
+    bool isValid() const;
+    /// has the worker finished (successfully or not)?
+    bool isReady() const;
+    /// block until the worker has finished.
+    /// on a worker thread of the same pool other queued tasks are run while waiting.
+    void wait() const;
+    /// block for at most 'ms' milliseconds, returns isReady()
+    /// NOTE: doesn't run queued tasks, so don't wait for a task which is still queued on a worker thread of the same pool
+    bool waitFor(int ms) const;
+
+    /// bytes consumed by the parser so far
+    size_t getBytesConsumed() const;
+    /// total input size in bytes (0 if unknown)
+    size_t getBytesTotal() const;
+    /// progress between 0 and 1 (0 if the total size is unknown)
+    float getProgress() const;
+
+    /// ask the worker to stop parsing (cooperative)
+    void cancel();
+    bool isCancelled() const;
+
+    /// wait for the result and move the document into 'document' (no deep copy!).
+    /// returns false on error or cancellation; can only be called once.
+    bool get(ofxJsonDocument& document);
+    /// error message (empty on success)
+    string getError() const;
+protected:
+    ofxJsonLoadHandle(const shared_ptr<ofxJsonLoadState>& state) : state_(state) {}
+    shared_ptr<ofxJsonLoadState> state_;
+};
+
+/*///////////// ofxJsonSaveHandle ////////////////////////////*/
+
+/// state shared between an ofxJsonSaveHandle and its worker (internal)
+struct ofxJsonSaveState {
+    chrono::steady_clock::time_point requestTime;
+    double snapshotTime = 0;
+    atomic<bool> coalesced{false};
+    mutable mutex mtx;
+    mutable condition_variable condition;
+    bool done = false;
+    bool result = false;
+    string error;
+    size_t bytesWritten = 0;
+    double latency = 0;
+    void finish(bool result, const string& error, size_t bytesWritten);
+};
+
+/// snapshot waiting to be written (internal)
+struct ofxJsonSaveJob {
+    ofxJsonDocument snapshot;
+    string path;
+    bool pretty;
+    bool atomic;
+    vector<shared_ptr<ofxJsonSaveState>> states; // this request and the ones it superseded
+};
+
+/// pending saves of a document, written one after the other by a single task (internal)
+struct ofxJsonSaveQueue {
+    mutex mtx;
+    deque<shared_ptr<ofxJsonSaveJob>> jobs;
+    bool running = false;
+};
+
+/// future-like handle for an asynchronous save operation.
+/// a default constructed (invalid) handle behaves like a failed save which has already finished.
+class ofxJsonSaveHandle {
+    friend class ofxJsonDocument;
+public:
+    ofxJsonSaveHandle() {} // invalid handle
+
+    bool isValid() const;
+    /// has the file been written (successfully or not)?
+    bool isReady() const;
+    /// block until the file has been written
+    void wait() const;
+    /// block for at most 'ms' milliseconds, returns isReady()
+    bool waitFor(int ms) const;
+
+    /// wait for the result. returns false if the file couldn't be written.
+    /// NOTE: a coalesced save reports the result of the save which superseded it.
+    bool getResult() const;
+    /// error message (empty on success)
+    string getError() const;
+    /// was the snapshot replaced by a newer one before it could be written?
+    bool isCoalesced() const;
+
+    /// time spent on the calling thread for the snapshot in milliseconds
+    double getSnapshotTime() const;
+    /// time from the request until the file has been written in milliseconds
+    double getLatency() const;
+    /// size of the written file in bytes
+    size_t getBytesWritten() const;
+protected:
+    ofxJsonSaveHandle(const shared_ptr<ofxJsonSaveState>& state) : state_(state) {}
+    shared_ptr<ofxJsonSaveState> state_;
+};
+
+/*///////////// ofxJsonLinesReader ////////////////////////////*/
+
+/// reads newline delimited JSON (JSON Lines / NDJSON) or concatenated JSON values record by record.
+/// records are parsed into reused documents, so memory usage doesn't grow with the input size.
+class ofxJsonLinesReader {
+public:
+    ofxJsonLinesReader();
+    ofxJsonLinesReader(const ofxJsonLinesReader&) = delete;
+    ~ofxJsonLinesReader();
+    ofxJsonLinesReader& operator=(const ofxJsonLinesReader&) = delete;
+
+    bool open(const string& path, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    /// NOTE: the stream must stay alive until close() is called
+    bool open(istream& is, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    void close();
+    bool isOpen() const;
+
+    /// read the next record; returns false at the end of the input.
+    /// a record which fails to parse is skipped, reading continues on the line after the one where it started.
+    bool next();
+    /// the current record (overwritten by the next call to next())
+    ofxJsonDocument& getRecord();
+    /// read up to 'count' records into 'records', reusing the documents which are already in the vector.
+    /// the vector is resized to the number of records read (0 at the end of the input).
+    size_t nextBatch(vector<ofxJsonDocument>& records, size_t count);
+
+    /// parse a whole file on multiple threads.
+    /// the (memory mapped) file is split into chunks at line boundaries, which are parsed on the thread pool.
+    /// 'callback' is called for every record:
+    /// ordered = true -> in input order on the calling thread (after a chunk has been parsed completely);
+    /// ordered = false -> on the worker threads as soon as a record is ready (so it must be thread-safe!).
+    /// the record is only valid during the callback. returns the number of records.
+    /// if the callback throws, the remaining chunks are skipped and the exception is rethrown
+    /// on the calling thread once all tasks have finished.
+    /// falls back to sequential reading if the file can't be mapped.
+    /// NOTE: don't call this from a task of the same thread pool.
+    size_t readParallel(const string& path, const function<void(ofxJsonValueRef record)>& callback,
+                        bool ordered = true, size_t chunkSize = 1 << 20,
+                        ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+
+    /// number of records read so far
+    size_t getNumRecords() const;
+    /// number of records skipped because of parse errors
+    size_t getNumErrors() const;
+protected:
+    bool readRecord(ofxJsonDocument& record);
+    template<typename Callback>
+    static size_t readChunk(const char* data, size_t size, size_t offset, size_t& numErrors,
+                            rapidjson::Document& temp, Callback&& callback);
+    unique_ptr<ifstream> file_;
+    unique_ptr<ofxJsonBufferedIStream> stream_;
+    ofxJsonDocument record_;
+    size_t numRecords_;
+    size_t numErrors_;
+};
+
+/*///////////// ofxJsonSaxReader ////////////////////////////*/
+
+/// return value of ofxJsonSaxReader callbacks
+enum ofxJsonSaxResult {
+    OFX_JSON_SAX_CONTINUE,
+    OFX_JSON_SAX_SKIP, // skip the current container (or the value of the current key)
+    OFX_JSON_SAX_STOP  // stop parsing
+};
+
+/// event based (SAX) reader which doesn't build a DOM.
+/// set the callbacks you're interested in, all others are ignored.
+/// strings (and keys) are only valid during the callback!
+///
+/// returning OFX_JSON_SAX_SKIP from onStartObject/onStartArray skips the whole container
+/// (including the matching onEndObject/onEndArray), from onKey it skips the member's value.
+/// skipped values are still scanned but no callbacks are invoked.
+class ofxJsonSaxReader {
+public:
+    ofxJsonSaxReader();
+    ofxJsonSaxReader(const ofxJsonSaxReader&) = delete;
+    ~ofxJsonSaxReader();
+    ofxJsonSaxReader& operator=(const ofxJsonSaxReader&) = delete;
+
+    /// parse JSON data and invoke the callbacks.
+    /// returns true on success or if stopped by a callback, false on parse errors.
+    bool parseFile(const string& path, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    bool parseStream(istream& is, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    bool parseBuffer(const string& buffer);
+    bool parseBuffer(const ofBuffer& buffer);
+    bool parseBuffer(const char* data, size_t size);
+
+    /// was the last parse stopped by a callback?
+    bool isStopped() const;
+    /// current nesting depth (not counting skipped containers)
+    size_t getDepth() const;
+
+    /// callbacks
+    function<ofxJsonSaxResult()> onNull;
+    function<ofxJsonSaxResult(bool b)> onBool;
+    /// integers which fit into int64_t; if not set, they are passed to onNumber()
+    function<ofxJsonSaxResult(int64_t n)> onInt;
+    function<ofxJsonSaxResult(double n)> onNumber;
+    function<ofxJsonSaxResult(const char* s, size_t length)> onString;
+    function<ofxJsonSaxResult(const char* s, size_t length)> onKey;
+    function<ofxJsonSaxResult()> onStartObject;
+    function<ofxJsonSaxResult(size_t memberCount)> onEndObject;
+    function<ofxJsonSaxResult()> onStartArray;
+    function<ofxJsonSaxResult(size_t elementCount)> onEndArray;
+protected:
+    struct Handler;
+    template<typename InputStream>
+    bool parse(InputStream& is);
+    rapidjson::Reader reader_;
+    size_t depth_;
+    size_t skipDepth_; // > 0 while skipping a container
+    bool skipNext_; // skip the next value
+    bool stopped_;
+};
+
+/*///////////// ofxJsonCursor ////////////////////////////*/
+
+enum ofxJsonTokenType {
+    OFX_JSON_TOKEN_NONE, // before the first or after the last token
+    OFX_JSON_TOKEN_START_OBJECT,
+    OFX_JSON_TOKEN_END_OBJECT,
+    OFX_JSON_TOKEN_START_ARRAY,
+    OFX_JSON_TOKEN_END_ARRAY,
+    OFX_JSON_TOKEN_STRING,
+    OFX_JSON_TOKEN_NUMBER,
+    OFX_JSON_TOKEN_BOOL,
+    OFX_JSON_TOKEN_NULL
+};
+
+/// pull parser: the caller advances token by token with next().
+/// uses rapidjson's iterative (non-recursive) parser and doesn't build a DOM.
+///
+/// object members are reported as a single token: the value token carries the member's key.
+/// start tokens have the depth of their container, the tokens inside have depth + 1.
+class ofxJsonCursor {
+public:
+    ofxJsonCursor();
+    ofxJsonCursor(const ofxJsonCursor&) = delete;
+    ~ofxJsonCursor();
+    ofxJsonCursor& operator=(const ofxJsonCursor&) = delete;
+
+    /// memory maps the file if possible, otherwise reads it in blocks
+    bool openFile(const string& path, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    /// NOTE: the stream must stay alive until close() is called
+    bool openStream(istream& is, size_t bufferSize = ofxJsonBufferedIStream::defaultBufferSize);
+    /// NOTE: the data is not copied and must stay alive until close() is called
+    bool openBuffer(const char* data, size_t size);
+    bool openBuffer(const string& buffer);
+    bool openBuffer(const ofBuffer& buffer);
+    /// temporaries would be destroyed while the cursor still reads them
+    bool openBuffer(string&& buffer) = delete;
+    bool openBuffer(ofBuffer&& buffer) = delete;
+    void close();
+
+    /// advance to the next token. returns false at the end of the document or on parse errors.
+    bool next();
+    /// skip a container: if the current token starts a container, advance to its end token,
+    /// otherwise advance to the end token of the enclosing container.
+    bool skip();
+    bool hasError() const;
+
+    /// current token
+    ofxJsonTokenType getType() const;
+    size_t getDepth() const;
+    /// only object members have a key
+    bool hasKey() const;
+    const string& getKey() const;
+    /// string value (without copy: only valid until the next call to next())
+    const char* getStringData() const;
+    size_t getStringLength() const;
+    string getString() const;
+    bool getBool() const;
+    /// integer numbers which fit into int64_t
+    bool isInt() const;
+    /// other numbers are truncated toward zero and clamped to the int64_t range
+    int64_t getInt() const;
+    double getDouble() const;
+protected:
+    struct Handler;
+    typedef rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> MemoryInputStream;
+    template<typename InputStream>
+    bool parseNext(InputStream& is);
+    rapidjson::Reader reader_;
+    unique_ptr<ofxJsonMappedFile> file_;
+    unique_ptr<ifstream> ifstream_;
+    unique_ptr<ofxJsonBufferedIStream> stream_;
+    unique_ptr<rapidjson::MemoryStream> memory_;
+    unique_ptr<MemoryInputStream> memoryStream_;
+    ofxJsonTokenType type_;
+    size_t depth_;
+    string key_;
+    bool hasKey_;
+    const char* string_;
+    size_t length_;
+    int64_t int_;
+    double double_;
+    bool isInt_;
+    bool bool_;
+    bool error_;
+};
+
+/*///////////// ofxJsonLazyDocument ////////////////////////////*/
+
+/// document which only builds rapidjson::Values for the parts which are actually accessed.
+///
+/// loading does a single structural pass which records where each container begins and ends.
+/// find() and operator[] only parse the containers on the way to the requested value
+/// (one level each, nested containers are skipped) and then the requested subtree itself.
+/// the returned ofxJsonValueRef is a normal, fully built value.
+///
+/// getRoot(), getDocument() and the save methods build the whole document.
+/// there is no lazy iteration: iterate over a value returned by find() or operator[] to build only that part.
+/// NOTE: syntax errors in parts which haven't been accessed yet are only detected once they are built.
+/// the broken part is replaced by null and hasError() returns true; the save methods fail from then on.
+class ofxJsonLazyDocument {
+public:
+    ofxJsonLazyDocument();
+    ofxJsonLazyDocument(const ofxJsonLazyDocument&) = delete;
+    ~ofxJsonLazyDocument();
+    ofxJsonLazyDocument& operator=(const ofxJsonLazyDocument&) = delete;
+
+    /// memory maps the file if possible, otherwise reads it into memory
+    bool loadFromFile(const string& path);
+    /// the buffer is copied
+    bool loadFromBuffer(const string& buffer);
+    bool loadFromBuffer(const ofBuffer& buffer);
+
+    /// save JSON data (builds the whole document).
+    /// fail if the document has errors (saveToView() returns an empty view, 'size' is set to 0,
+    /// saveToFileAsync() returns an invalid handle).
+    bool saveToFile(const string& path, bool pretty = true, bool atomic = false);
+    ofxJsonSaveHandle saveToFileAsync(const string& path, bool pretty = true, bool atomic = false,
+                                      ofxJsonThreadPool& pool = ofxJsonThreadPool::getDefault());
+    bool saveToBuffer(string& buffer, bool pretty = true);
+    bool saveToBuffer(ofBuffer& buffer, bool pretty = true);
+    bool saveToBuffer(char* data, size_t capacity, size_t& size, bool pretty = true);
+    bool saveToBuffer(ofxJsonSegmentedOStream& buffer, bool pretty = true);
+    ofxJsonBufferView saveToView(bool pretty = true);
+    /// see ofxJsonDocument::serializedSize() (builds the whole document). returns 0 if the document has errors.
+    size_t serializedSize(bool pretty = true);
+    /// see ofxJsonDocument::setMaxDecimalPlaces()
+    void setMaxDecimalPlaces(int places);
+    int getMaxDecimalPlaces() const;
+    /// clear document and release the source data
+    void clear();
+
+    /// see ofxJsonDocument::find()
+    ofxJsonValueIterator find(const string& key);
+    /// see ofxJsonDocument::operator[]
+    ofxJsonValueRef operator[](const string& key);
+    ofxJsonValueIterator end();
+
+    /// get root value reference (builds the whole document, check hasError() afterwards)
+    ofxJsonValueRef getRoot();
+    /// get the actual rapidjson::Document (builds the whole document, check hasError() afterwards)
+    rapidjson::Document& getDocument();
+    /// has a part of the document failed to build? (reset by loading or clear())
+    bool hasError() const;
+
+    /// size of the source data in bytes
+    size_t getSourceSize() const;
+    /// number of containers which haven't been built yet
+    size_t getNumPending() const;
+protected:
+    /// containers which haven't been built yet are stored as constant strings
+    /// pointing to their source text. strings which have been built are always copied,
+    /// so a string pointing into the source data is a placeholder.
+    bool isPending(const rapidjson::Value& value) const;
+    void makePending(rapidjson::Value& value, size_t begin, size_t end);
+    /// build a pending container one level deep
+    bool buildShallow(rapidjson::Value& value);
+    /// build all pending containers inside a value
+    bool buildDeep(rapidjson::Value& value);
+    /// build the whole document, returns !hasError()
+    bool buildAll();
+    bool parseRange(rapidjson::Value& value, size_t begin, size_t end);
+    bool parseString(rapidjson::Value& value, size_t begin, size_t end);
+    rapidjson::Value* resolve(const rapidjson::Pointer& ptr);
+    bool index();
+    size_t findContainerEnd(size_t begin) const;
+    size_t findStringEnd(size_t begin) const;
+    size_t skipWhitespace(size_t pos) const;
+    void printError(rapidjson::ParseErrorCode error, size_t offset);
+
+    ofxJsonDocument document_;
+    rapidjson::Document scratch_; // shares the allocator of document_
+    unique_ptr<ofxJsonMappedFile> file_;
+    string buffer_;
+    const char* data_;
+    size_t size_;
+    vector<pair<size_t, size_t>> containers_; // begin/end offsets in source order
+    size_t numPending_;
+    bool error_;
 };
 
 /*///////////// ofxJsonValueRef ////////////////////////////*/
@@ -209,7 +1636,9 @@ public:
     ///
     /// document["/key"] = 4.7
     ///
-    /// template for primitive types:
+    /// template for primitive types.
+    /// floats are marked as single precision and saved in their shortest form
+    /// (0.1f -> 0.1 instead of 0.10000000149011612), so cast to double if you need the exact value.
     template<typename T>
     ofxJsonValueRef& operator=(T value);
     /// catches string literals (without copying):
@@ -268,6 +1697,9 @@ public:
     /// test if two ofxJsonValueRefs point to the same rapidjson::Value
     bool operator==(const ofxJsonValueRef& other);
     bool operator!=(const ofxJsonValueRef& other);
+    /// estimated bytes the value and its children occupy in the memory pool of the document
+    /// (strings which aren't copied, e.g. in-situ parsed ones, only count with their value)
+    size_t getFootprint() const;
 
     /// explicit getters
     bool getBool() const;
@@ -4,299 +4,3610 @@
 
 /// IMPLEMENTATION ///
 
+/*///////////// ofxJsonBufferOStream ////////////////*/
+
+template<typename Buffer>
+const size_t ofxJsonBufferOStream<Buffer>::minCapacity;
+
+template<typename Buffer>
+inline void ofxJsonBufferOStream<Buffer>::reset(){
+    // the old contents are simply overwritten. resizing to the full capacity
+    // would zero-fill it on every save, so the spare capacity is only taken by grow().
+    if (buffer_.size() < minCapacity){
+        buffer_.resize(minCapacity);
+    }
+    update(0);
+}
+
+template<typename Buffer>
+inline void ofxJsonBufferOStream<Buffer>::finish(){
+    size_t size = current_ - begin_;
+    buffer_.resize(size);
+    update(size); // the next Put() grows the buffer again
+}
+
+template<typename Buffer>
+inline void ofxJsonBufferOStream<Buffer>::grow(size_t n){
+    size_t size = current_ - begin_;
+    size_t capacity = end_ - begin_;
+    if (getCapacity(buffer_) >= size + n){
+        buffer_.resize(getCapacity(buffer_)); // use the spare capacity first (no reallocation)
+    } else {
+        buffer_.resize(std::max<size_t>(std::max<size_t>(capacity * 2, minCapacity), size + n));
+    }
+    update(size);
+}
+
+template<typename Buffer>
+inline void ofxJsonBufferOStream<Buffer>::update(size_t size){
+    begin_ = getData(buffer_);
+    current_ = begin_ + size;
+    end_ = begin_ + buffer_.size();
+}
+
+/*///////////// ofxJsonSegmentedOStream ////////////////*/
+
+inline ofxJsonChunkPool::ofxJsonChunkPool(size_t chunkSize, size_t maxFree)
+    : chunkSize_(std::max<size_t>(chunkSize, 64)), maxFree_(maxFree) {}
+
+inline ofxJsonChunkPool::~ofxJsonChunkPool() {
+    trim();
+}
+
+inline char* ofxJsonChunkPool::allocate(){
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!free_.empty()){
+            char* chunk = free_.back();
+            free_.pop_back();
+            return chunk;
+        }
+    }
+    return new char[chunkSize_];
+}
+
+inline void ofxJsonChunkPool::release(char* chunk){
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (free_.size() < maxFree_){
+            free_.push_back(chunk);
+            return;
+        }
+    }
+    delete[] chunk;
+}
+
+inline void ofxJsonChunkPool::trim(){
+    lock_guard<mutex> lock(mutex_);
+    for (auto& chunk : free_){
+        delete[] chunk;
+    }
+    free_.clear();
+}
+
+inline ofxJsonChunkPool& ofxJsonChunkPool::getDefault(){
+    static ofxJsonChunkPool pool;
+    return pool;
+}
+
+inline ofxJsonSegmentedOStream::ofxJsonSegmentedOStream(ofxJsonChunkPool& pool)
+    : pool_(pool), size_(0), begin_(nullptr), current_(nullptr), end_(nullptr) {}
+
+inline ofxJsonSegmentedOStream::~ofxJsonSegmentedOStream() {
+    clear();
+}
+
+inline void ofxJsonSegmentedOStream::clear(){
+    for (auto& chunk : chunks_){
+        pool_.release(chunk);
+    }
+    chunks_.clear();
+    size_ = 0;
+    begin_ = current_ = end_ = nullptr;
+}
+
+inline ofxJsonBufferView ofxJsonSegmentedOStream::getSegment(size_t index) const {
+    size_t size = (index + 1 == chunks_.size()) ? current_ - begin_ : pool_.getChunkSize();
+    return ofxJsonBufferView(chunks_[index], size);
+}
+
+inline void ofxJsonSegmentedOStream::copyTo(char* data) const {
+    for (size_t i = 0; i < chunks_.size(); ++i){
+        ofxJsonBufferView segment = getSegment(i);
+        memcpy(data, segment.data, segment.size);
+        data += segment.size;
+    }
+}
+
+inline void ofxJsonSegmentedOStream::copyTo(string& buffer) const {
+    buffer.resize(size());
+    if (!buffer.empty()){
+        copyTo(&buffer[0]);
+    }
+}
+
+inline void ofxJsonSegmentedOStream::copyTo(ofBuffer& buffer) const {
+    buffer.resize(size());
+    if (buffer.size() > 0){
+        copyTo(buffer.getData());
+    }
+}
+
+inline void ofxJsonSegmentedOStream::writeTo(ofxJsonFileOStream& os) const {
+    vector<ofxJsonBufferView> runs(chunks_.size());
+    for (size_t i = 0; i < runs.size(); ++i){
+        runs[i] = getSegment(i);
+    }
+    os.write(runs.data(), runs.size());
+}
+
+#ifndef _WIN32
+inline bool ofxJsonSegmentedOStream::writeTo(int fd) const {
+    vector<struct iovec> iov(chunks_.size());
+    for (size_t i = 0; i < iov.size(); ++i){
+        ofxJsonBufferView segment = getSegment(i);
+        iov[i].iov_base = const_cast<char*>(segment.data);
+        iov[i].iov_len = segment.size;
+    }
+    return ofxJsonFileOStream::writeAll(fd, iov.data(), iov.size());
+}
+#endif
+
+inline void ofxJsonSegmentedOStream::write(const Ch* s, size_t n){
+    while (n > 0){
+        if (current_ == end_){
+            addChunk();
+        }
+        size_t count = std::min<size_t>(n, end_ - current_);
+        memcpy(current_, s, count);
+        current_ += count;
+        s += count;
+        n -= count;
+    }
+}
+
+inline void ofxJsonSegmentedOStream::addChunk(){
+    size_ += current_ - begin_;
+    chunks_.push_back(pool_.allocate());
+    begin_ = current_ = chunks_.back();
+    end_ = begin_ + pool_.getChunkSize();
+}
+
 /*///////////// ofxPrettyJsonWriter ////////////////*/
 
-inline ofxPrettyJsonWriter::ofxPrettyJsonWriter() {}
-inline ofxPrettyJsonWriter::~ofxPrettyJsonWriter() {}
+inline ofxPrettyJsonWriter::ofxPrettyJsonWriter() {}
+inline ofxPrettyJsonWriter::~ofxPrettyJsonWriter() {}
+
+template<typename T>
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::operator<<(T&& val){
+    doAdd(forward<T>(val));
+    return *this;
+}
+
+inline void ofxPrettyJsonWriter::reset(){
+    stream_.reset();
+    output_.setTarget(stream_);
+    writer_.Reset(output_);
+}
+
+inline void ofxPrettyJsonWriter::reset(ofxJsonSegmentedOStream& output){
+    output_.setTarget(output);
+    writer_.Reset(output_);
+}
+
+inline bool ofxPrettyJsonWriter::isComplete() const {
+    return writer_.IsComplete();
+}
+
+inline bool ofxPrettyJsonWriter::saveToBuffer(string& buffer){
+    if (isComplete()){
+        if (output_.getSegmented()){
+            output_.getSegmented()->copyTo(buffer);
+        } else {
+            buffer.assign(stream_.data(), stream_.size());
+        }
+        return true;
+    } else {
+        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        return false;
+    }
+}
+
+inline bool ofxPrettyJsonWriter::saveToBuffer(ofBuffer& buffer){
+    if (isComplete()){
+        if (output_.getSegmented()){
+            output_.getSegmented()->copyTo(buffer);
+        } else {
+            buffer.set(stream_.data(), stream_.size());
+        }
+        return true;
+    } else {
+        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        return false;
+    }
+}
+
+inline ofxJsonBufferView ofxPrettyJsonWriter::saveToView() const {
+    if (output_.getSegmented()){
+        ofLogWarning("ofxPrettyJsonWriter") << "can't make a view of a segmented output!\n";
+        return ofxJsonBufferView();
+    } else if (isComplete()){
+        return ofxJsonBufferView(stream_.data(), stream_.size());
+    } else {
+        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        return ofxJsonBufferView();
+    }
+}
+
+inline bool ofxPrettyJsonWriter::takeBuffer(string& buffer){
+    if (output_.getSegmented()){
+        ofLogWarning("ofxPrettyJsonWriter") << "can't take the buffer of a segmented output!\n";
+        return false;
+    } else if (isComplete()){
+        stream_.finish();
+        buffer.swap(buffer_);
+        buffer_.clear(); // the old memory of 'buffer' is reused after reset()
+        stream_.reset();
+        return true;
+    } else {
+        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        return false;
+    }
+}
+
+inline bool ofxPrettyJsonWriter::saveToFile(const string& path, bool atomic){
+    if (isComplete()){
+        ofxJsonFileOStream os(0); // the data is written in one go, no need for a block
+
+        if (!os.open(path, atomic)){
+            ofLogWarning("ofxPrettyJsonWriter") << "couldn't open file!\n";
+            return false;
+        }
+        if (output_.getSegmented()){
+            output_.getSegmented()->writeTo(os);
+        } else {
+            os.write(stream_.data(), stream_.size());
+        }
+        if (!os.close()){
+            ofLogWarning("ofxPrettyJsonWriter") << "couldn't write file!\n";
+            return false;
+        }
+        return true;
+    } else {
+        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        return false;
+    }
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::setMaxDecimalPlaces(int places){
+    writer_.SetMaxDecimalPlaces(places);
+    return *this;
+}
+
+inline int ofxPrettyJsonWriter::getMaxDecimalPlaces() const {
+    return writer_.GetMaxDecimalPlaces();
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::startObject(){
+    writer_.StartObject(); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::endObject(){
+    writer_.EndObject(); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::startArray(){
+    writer_.StartArray(); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::endArray(){
+    writer_.EndArray(); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addKey(const string& s){
+    writer_.Key(s.data(), s.size(), true); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addString(const string& s){
+    writer_.String(s.data(), s.size(), true); return *this;
+}
+
+template<typename T>
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addNumber(T n){
+    doAdd(n); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addNull(){
+    writer_.Null(); return *this;
+}
+
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addBool(bool b){
+    writer_.Bool(b); return *this;
+}
+
+
+template<typename T>
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addArray(const vector<T>& vec){
+    doAdd(vec);
+    return *this;
+}
+
+template<typename T>
+inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addObject(const unordered_map<string, T>& map){
+    doAdd(map);
+    return *this;
+}
+
+inline void ofxPrettyJsonWriter::doAdd(uint32_t n){writer_.Uint(n);}
+inline void ofxPrettyJsonWriter::doAdd(int32_t n){writer_.Int(n);}
+inline void ofxPrettyJsonWriter::doAdd(uint64_t n){writer_.Uint64(n);}
+inline void ofxPrettyJsonWriter::doAdd(int64_t n){writer_.Int64(n);}
+inline void ofxPrettyJsonWriter::doAdd(float n){writer_.Float(n);}
+inline void ofxPrettyJsonWriter::doAdd(double n){writer_.Double(n);}
+inline void ofxPrettyJsonWriter::doAdd(const string& s){writer_.String(s.data(), s.size(), true);}
+template<int N>
+inline void ofxPrettyJsonWriter::doAdd(const char(&s)[N]){writer_.String(s, N-1, true);}
+inline void ofxPrettyJsonWriter::doAdd(bool b){writer_.Bool(b);}
+template<typename T>
+inline void ofxPrettyJsonWriter::doAdd(const vector<T>& vec){
+    writer_.StartArray();
+    for (auto& k : vec){
+        doAdd(k);
+    }
+    writer_.EndArray();
+}
+template<typename T>
+inline void ofxPrettyJsonWriter::doAdd(const unordered_map<string, T>& map){
+    writer_.StartObject();
+    for (auto& e : map){
+        addKey(e.first);
+        doAdd(e.second);
+    }
+    writer_.EndObject();
+}
+
+/*///////////// ofxJsonMappedFile ////////////////////*/
+
+inline ofxJsonMappedFile::ofxJsonMappedFile()
+    : data_(nullptr), size_(0), mappedSize_(0) {}
+
+inline ofxJsonMappedFile::~ofxJsonMappedFile() {
+    close();
+}
+
+inline bool ofxJsonMappedFile::open(const string& path){
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        ::close(fd); // only regular files can be mapped
+        return false;
+    }
+    size_t size = st.st_size;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (size / pageSize + 1) * pageSize; // always leave room for the zero terminator
+    // reserve a zero filled region first and then map the file on top of it.
+    // this way the data is guaranteed to be zero terminated, even if the file size is a multiple of the page size.
+    void* region = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (region == MAP_FAILED){
+        ::close(fd);
+        return false;
+    }
+    if (size > 0){
+        void* file = mmap(region, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (file == MAP_FAILED){
+            munmap(region, mappedSize);
+            ::close(fd);
+            return false;
+        }
+        madvise(file, size, MADV_SEQUENTIAL); // the parser reads the data front to back
+    }
+    ::close(fd); // the mapping keeps its own reference to the file
+
+    data_ = static_cast<char*>(region);
+    size_ = size;
+    mappedSize_ = mappedSize;
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline void ofxJsonMappedFile::close(){
+#ifndef _WIN32
+    if (data_){
+        munmap(data_, mappedSize_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mappedSize_ = 0;
+}
+
+inline bool ofxJsonMappedFile::isOpen() const {
+    return data_ != nullptr;
+}
+
+inline char* ofxJsonMappedFile::getData(){
+    return data_;
+}
+
+inline size_t ofxJsonMappedFile::size() const {
+    return size_;
+}
+
+/*///////////// ofxJsonThreadPool ////////////////////*/
+
+inline ofxJsonThreadPool::ofxJsonThreadPool(size_t numThreads)
+    : next_(0), pending_(0), quit_(false) {
+    if (numThreads == 0){
+        numThreads = std::max<size_t>(thread::hardware_concurrency(), 1);
+    }
+    for (size_t i = 0; i < numThreads; ++i){
+        queues_.emplace_back(new Queue());
+    }
+    for (size_t i = 0; i < numThreads; ++i){
+        threads_.emplace_back(&ofxJsonThreadPool::run, this, i);
+    }
+}
+
+inline ofxJsonThreadPool::~ofxJsonThreadPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        quit_ = true;
+    }
+    condition_.notify_all();
+    for (auto& t : threads_){
+        t.join();
+    }
+}
+
+inline void ofxJsonThreadPool::push(function<void()> task){
+    WorkerInfo& info = getWorkerInfo();
+    size_t index = (info.pool == this) ? info.index : next_++ % queues_.size();
+    // count the task before it becomes visible, otherwise a worker could pop it
+    // and decrement 'pending_' first (which would wrap around)
+    {
+        lock_guard<mutex> lock(mutex_);
+        ++pending_;
+    }
+    {
+        lock_guard<mutex> lock(queues_[index]->mtx);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+inline size_t ofxJsonThreadPool::getNumThreads() const {
+    return threads_.size();
+}
+
+inline bool ofxJsonThreadPool::runPendingTask(){
+    WorkerInfo& info = getWorkerInfo();
+    size_t index = (info.pool == this) ? info.index : 0;
+    function<void()> task;
+    if (!pop(index, task)){
+        return false;
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        --pending_;
+    }
+    task();
+    return true;
+}
+
+inline bool ofxJsonThreadPool::isWorkerThread() const {
+    return getWorkerInfo().pool == this;
+}
+
+inline ofxJsonThreadPool& ofxJsonThreadPool::getDefault(){
+    static ofxJsonThreadPool pool;
+    return pool;
+}
+
+inline ofxJsonThreadPool::WorkerInfo& ofxJsonThreadPool::getWorkerInfo(){
+    static thread_local WorkerInfo info { nullptr, 0 };
+    return info;
+}
+
+inline bool ofxJsonThreadPool::pop(size_t index, function<void()>& task){
+    size_t n = queues_.size();
+    for (size_t i = 0; i < n; ++i){
+        Queue& q = *queues_[(index + i) % n];
+        lock_guard<mutex> lock(q.mtx);
+        if (!q.tasks.empty()){
+            if (i == 0){
+                // own queue: oldest task first
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            } else {
+                // steal from the other end
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void ofxJsonThreadPool::run(size_t index){
+    getWorkerInfo() = WorkerInfo { this, index };
+    for (;;){
+        if (!runPendingTask()){
+            unique_lock<mutex> lock(mutex_);
+            condition_.wait(lock, [this](){ return quit_ || pending_ > 0; });
+            if (pending_ == 0){
+                return; // quit (but only after all tasks are done)
+            }
+        }
+    }
+}
+
+/*///////////// ofxJsonBufferedIStream ////////////////////*/
+
+inline ofxJsonBufferedIStream::ofxJsonBufferedIStream(istream& is, size_t bufferSize)
+    : is_(is), buffer_(std::max<size_t>(bufferSize, 4)), blockSize_(buffer_.size()), bufferLast_(nullptr),
+      current_(buffer_.data()), mark_(nullptr), readCount_(0), count_(0), eof_(false) {
+    read();
+}
+
+inline ofxJsonBufferedIStream::~ofxJsonBufferedIStream() {}
+
+inline void ofxJsonBufferedIStream::read(){
+    if (current_ < bufferLast_){
+        ++current_;
+    } else if (!eof_){
+        // move the marked data to the front and append the next block
+        size_t keep = mark_ ? static_cast<size_t>(buffer_.data() + readCount_ - mark_) : 0;
+        size_t discard = readCount_ - keep;
+        count_ += discard;
+        if (keep > 0){
+            if (buffer_.size() < keep + blockSize_){
+                buffer_.resize(keep + blockSize_);
+            }
+            memmove(buffer_.data(), buffer_.data() + discard, keep);
+            mark_ = buffer_.data();
+        }
+        is_.read(buffer_.data() + keep, blockSize_);
+        size_t n = is_.gcount();
+        readCount_ = keep + n;
+        bufferLast_ = buffer_.data() + readCount_ - 1;
+        current_ = buffer_.data() + keep;
+
+        if (n < blockSize_){
+            // terminate with '\0' so the parser sees the end of the stream
+            buffer_[readCount_] = '\0';
+            ++bufferLast_;
+            eof_ = true;
+        }
+    }
+}
+
+inline void ofxJsonBufferedIStream::skipWhitespace(){
+    for (;;){
+        const Ch* end = bufferLast_ + 1;
+#ifdef RAPIDJSON_SIMD
+        current_ = const_cast<Ch*>(rapidjson::SkipWhitespace_SIMD(current_, end));
+#else
+        current_ = const_cast<Ch*>(rapidjson::SkipWhitespace(current_, end));
+#endif
+        if (current_ != end || eof_){
+            return; // found a non-whitespace character (or the terminating '\0')
+        }
+        // the whole block was whitespace -> get the next one
+        current_ = bufferLast_;
+        read();
+    }
+}
+
+inline void ofxJsonBufferedIStream::mark(){
+    mark_ = current_;
+}
+
+inline void ofxJsonBufferedIStream::unmark(){
+    mark_ = nullptr;
+}
+
+inline void ofxJsonBufferedIStream::rewind(){
+    if (mark_){
+        current_ = mark_;
+    }
+}
+
+/*///////////// ofxJsonFileOStream ////////////////////*/
+
+inline ofxJsonFileOStream::ofxJsonFileOStream(size_t bufferSize)
+    : buffer_(std::max<size_t>(bufferSize, 64)), current_(buffer_.data()), bufferEnd_(buffer_.data() + buffer_.size()), count_(0),
+#ifndef _WIN32
+      fd_(-1),
+#endif
+      error_(false) {}
+
+inline ofxJsonFileOStream::~ofxJsonFileOStream() {
+    if (tempPath_.empty()){
+        close();
+    } else {
+        discard();
+    }
+}
+
+inline bool ofxJsonFileOStream::open(const string& path, bool atomic){
+    if (isOpen()){
+        close();
+    }
+    path_ = path;
+    error_ = false;
+    current_ = buffer_.data();
+    count_ = 0;
+#ifndef _WIN32
+    if (atomic){
+        // unique name in the same directory (rename() doesn't work across file systems)
+        static std::atomic<unsigned> counter{0};
+        tempPath_ = path + ".tmp" + to_string(getpid()) + "_" + to_string(counter++);
+        fd_ = ::open(tempPath_.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        // keep the permissions of an existing file (the temp file gets 0666 & umask).
+        // best effort: the owner can't be kept without privileges anyway.
+        struct stat st;
+        if (fd_ >= 0 && ::stat(path.c_str(), &st) == 0){
+            fchmod(fd_, st.st_mode & 07777);
+        }
+    } else {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+    if (fd_ < 0){
+        tempPath_.clear();
+        return false;
+    }
+    return true;
+#else
+    if (atomic){
+        static std::atomic<unsigned> counter{0};
+        tempPath_ = path + ".tmp" + to_string(counter++);
+    }
+    file_.open(atomic ? tempPath_ : path, ios::binary | ios::trunc);
+    if (!file_.is_open()){
+        tempPath_.clear();
+        return false;
+    }
+    return true;
+#endif
+}
+
+inline bool ofxJsonFileOStream::close(){
+    if (!isOpen()){
+        return false;
+    }
+    Flush();
+#ifndef _WIN32
+    if (!tempPath_.empty() && !error_ && fsync(fd_) != 0){
+        error_ = true; // the data must be on disk before the rename
+    }
+    if (::close(fd_) != 0){
+        error_ = true;
+    }
+    fd_ = -1;
+    if (!tempPath_.empty()){
+        if (error_ || std::rename(tempPath_.c_str(), path_.c_str()) != 0){
+            ::unlink(tempPath_.c_str());
+            error_ = true;
+        } else {
+            // make the rename itself durable
+            size_t slash = path_.find_last_of('/');
+            string dir = (slash == string::npos) ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+            int dirfd = ::open(dir.c_str(), O_RDONLY);
+            if (dirfd >= 0){
+                fsync(dirfd);
+                ::close(dirfd);
+            }
+        }
+        tempPath_.clear();
+    }
+#else
+    file_.close();
+    if (file_.fail()){
+        error_ = true;
+    }
+    if (!tempPath_.empty()){
+        // rename() doesn't replace existing files on Windows, MoveFileEx() does it in one step.
+        // if it fails the previous file is still there, so the temp file can be removed.
+        if (error_ || !MoveFileExA(tempPath_.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)){
+            std::remove(tempPath_.c_str());
+            error_ = true;
+        }
+        tempPath_.clear();
+    }
+#endif
+    return !error_;
+}
+
+inline void ofxJsonFileOStream::discard(){
+    if (!isOpen()){
+        return;
+    }
+    current_ = buffer_.data();
+#ifndef _WIN32
+    ::close(fd_);
+    fd_ = -1;
+    if (!tempPath_.empty()){
+        ::unlink(tempPath_.c_str());
+    }
+#else
+    file_.close();
+    if (!tempPath_.empty()){
+        std::remove(tempPath_.c_str());
+    }
+#endif
+    tempPath_.clear();
+}
+
+inline bool ofxJsonFileOStream::isOpen() const {
+#ifndef _WIN32
+    return fd_ >= 0;
+#else
+    return file_.is_open();
+#endif
+}
+
+inline size_t ofxJsonFileOStream::size() const {
+    return count_ + (current_ - buffer_.data());
+}
+
+inline void ofxJsonFileOStream::Flush(){
+    writeBlocks(buffer_.data(), current_ - buffer_.data());
+    count_ += current_ - buffer_.data();
+    current_ = buffer_.data();
+}
+
+inline void ofxJsonFileOStream::write(const Ch* s, size_t n){
+    size_t avail = bufferEnd_ - current_;
+    if (n <= avail){
+        memcpy(current_, s, n);
+        current_ += n;
+    } else if (n < buffer_.size()){
+        // fill up the block to keep the writes large
+        memcpy(current_, s, avail);
+        current_ += avail;
+        Flush();
+        memcpy(current_, s + avail, n - avail);
+        current_ += n - avail;
+    } else {
+        // long run: write the block and the run with a single system call instead of copying
+        ofxJsonBufferView run(s, n);
+        write(&run, 1);
+    }
+}
+
+inline void ofxJsonFileOStream::write(const ofxJsonBufferView* runs, size_t count){
+#ifndef _WIN32
+    vector<struct iovec> iov(count + 1);
+    size_t used = current_ - buffer_.data();
+    iov[0].iov_base = buffer_.data();
+    iov[0].iov_len = used;
+    count_ += used;
+    for (size_t i = 0; i < count; ++i){
+        iov[i + 1].iov_base = const_cast<Ch*>(runs[i].data);
+        iov[i + 1].iov_len = runs[i].size;
+        count_ += runs[i].size;
+    }
+    if (!error_ && isOpen() && !writeAll(fd_, iov.data(), iov.size())){
+        error_ = true;
+    }
+    current_ = buffer_.data();
+#else
+    Flush(); // counts the block
+    for (size_t i = 0; i < count; ++i){
+        writeBlocks(runs[i].data, runs[i].size);
+        count_ += runs[i].size;
+    }
+#endif
+}
+
+#ifndef _WIN32
+inline bool ofxJsonFileOStream::writeAll(int fd, struct iovec* iov, size_t count){
+    const size_t maxCount = 1024; // IOV_MAX on Linux and macOS
+    while (count > 0){
+        ssize_t result = ::writev(fd, iov, (int)std::min(count, maxCount));
+        if (result < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        // skip what has been written (partial writes stop anywhere)
+        size_t written = result;
+        while (count > 0 && written >= iov->iov_len){
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0){
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+#endif
+
+inline void ofxJsonFileOStream::writeBlocks(const Ch* s, size_t n){
+    if (error_ || !isOpen()){
+        return;
+    }
+#ifndef _WIN32
+    while (n > 0){
+        ssize_t result = ::write(fd_, s, n);
+        if (result < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            error_ = true;
+            return;
+        }
+        s += result;
+        n -= result;
+    }
+#else
+    if (n > 0 && !file_.write(s, n)){
+        error_ = true;
+    }
+#endif
+}
+
+/*///////////// ofxJsonSimdLevel ////////////////////*/
+
+inline ofxJsonSimdLevel ofxJsonGetSimdLevel(){
+    return static_cast<ofxJsonSimdLevel>(rapidjson::internal::GetSimdLevel());
+}
+
+inline ofxJsonSimdLevel ofxJsonGetSupportedSimdLevel(){
+    return static_cast<ofxJsonSimdLevel>(rapidjson::internal::GetSupportedSimdLevel());
+}
+
+inline bool ofxJsonSetSimdLevel(ofxJsonSimdLevel level){
+    if (!rapidjson::internal::SetSimdLevel(static_cast<rapidjson::internal::SimdLevel>(level))){
+        ofLogWarning("ofxJsonSimdLevel") << "level " << ofxJsonGetSimdLevelName(level) << " not available!\n";
+        return false;
+    }
+    return true;
+}
+
+inline const char* ofxJsonGetSimdLevelName(ofxJsonSimdLevel level){
+    switch (level){
+    case OFX_JSON_SIMD_SSE2:
+        return "SSE2";
+    case OFX_JSON_SIMD_SSE42:
+        return "SSE4.2";
+    case OFX_JSON_SIMD_AVX2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+/*///////////// ofxJsonStructuralIndex ////////////////////*/
+
+inline ofxJsonStructuralIndex::ofxJsonStructuralIndex()
+    : data_(nullptr), size_(0), error_(rapidjson::kParseErrorNone), errorOffset_(0) {}
+
+inline bool ofxJsonStructuralIndex::build(const char* data, size_t size){
+    positions_.clear();
+    if (size > maxSize){
+        data_ = data;
+        size_ = size;
+        return setError(rapidjson::kParseErrorTermination, maxSize);
+    }
+    return scan(data, size, [this](size_t pos){
+        positions_.push_back(static_cast<uint32_t>(pos));
+        return true;
+    });
+}
+
+template<typename Callback>
+inline bool ofxJsonStructuralIndex::scan(const char* data, size_t size, Callback&& callback){
+    data_ = data;
+    size_ = size;
+    error_ = rapidjson::kParseErrorNone;
+    errorOffset_ = 0;
+
+    uint64_t prevEscaped = 0; // the previous block ended with an odd number of backslashes
+    uint64_t prevInString = 0; // all ones if the previous block ended inside a string
+    uint64_t prevPredecessor = 1; // the beginning of the input counts as whitespace
+    char tail[64];
+    FindMasksFunction findMasks = getFindMasks();
+    for (size_t base = 0; base < size; base += 64){
+        const char* block = data + base;
+        if (size - base < 64){
+            // pad the last block with whitespace
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, size - base);
+            block = tail;
+        }
+        Masks masks;
+        findMasks(block, masks);
+
+        uint64_t quotes = masks.quote & ~findEscaped(masks.backslash, prevEscaped);
+        // the opening quote and the string contents (but not the closing quote)
+        uint64_t inString = prefixXor(quotes) ^ prevInString;
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+        uint64_t control = masks.control & inString;
+        if (control){
+            return setError(rapidjson::kParseErrorStringEscapeInvalid, base + countTrailingZeros(control));
+        }
+        uint64_t op = masks.op & ~inString;
+        // other values (numbers, literals) begin after structural characters, quotes or whitespace
+        uint64_t predecessors = op | quotes | masks.whitespace;
+        uint64_t scalars = ((predecessors << 1) | prevPredecessor) & ~(op | quotes | masks.whitespace | inString);
+        prevPredecessor = predecessors >> 63;
+
+        uint64_t bits = op | quotes | scalars;
+        while (bits){
+            size_t pos = base + countTrailingZeros(bits);
+            if (!callback(pos)){
+                return setError(rapidjson::kParseErrorTermination, pos);
+            }
+            bits &= bits - 1;
+        }
+    }
+    if (prevInString){
+        return setError(rapidjson::kParseErrorStringMissQuotationMark, size);
+    }
+    return true;
+}
+
+template<typename Handler>
+struct ofxJsonStructuralIndex::KeyHandler
+        : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, KeyHandler<Handler>> {
+    KeyHandler(Handler& handler) : handler_(handler) {}
+    bool Default() { return false; }
+    bool String(const char* str, rapidjson::SizeType length, bool copy) {
+        return handler_.Key(str, length, copy);
+    }
+    Handler& handler_;
+};
+
+template<typename Handler>
+inline bool ofxJsonStructuralIndex::parse(Handler& handler){
+    enum State {
+        VALUE,
+        AFTER_VALUE,
+        OBJECT_BEGIN,
+        ARRAY_BEGIN,
+        KEY
+    };
+    struct Container {
+        bool isObject;
+        rapidjson::SizeType count;
+    };
+    vector<Container> stack;
+    State state = VALUE;
+    size_t n = positions_.size();
+    size_t i = 0;
+    if (!n){
+        return setError(rapidjson::kParseErrorDocumentEmpty, size_);
+    }
+    for (;;){
+        if (i == n){
+            if (state == AFTER_VALUE && stack.empty()){
+                return true;
+            }
+            // the input ended too early
+            rapidjson::ParseErrorCode error = rapidjson::kParseErrorValueInvalid;
+            if (state == KEY || state == OBJECT_BEGIN){
+                error = rapidjson::kParseErrorObjectMissName;
+            } else if (state == AFTER_VALUE){
+                error = stack.back().isObject ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket
+                                              : rapidjson::kParseErrorArrayMissCommaOrSquareBracket;
+            }
+            return setError(error, size_);
+        }
+        size_t pos = positions_[i];
+        char c = data_[pos];
+        switch (state){
+        case OBJECT_BEGIN:
+            if (c == '}'){
+                stack.pop_back();
+                if (!handler.EndObject(0)){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                i++;
+                state = AFTER_VALUE;
+                break;
+            }
+            // fall through
+        case KEY:
+            if (c != '"'){
+                return setError(rapidjson::kParseErrorObjectMissName, pos);
+            }
+            if (!parseString(handler, i, true)){
+                return false;
+            }
+            i += 2; // skip the closing quote
+            if (i == n || data_[positions_[i]] != ':'){
+                return setError(rapidjson::kParseErrorObjectMissColon, i == n ? size_ : positions_[i]);
+            }
+            i++;
+            state = VALUE;
+            break;
+        case ARRAY_BEGIN:
+            if (c == ']'){
+                stack.pop_back();
+                if (!handler.EndArray(0)){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                i++;
+                state = AFTER_VALUE;
+                break;
+            }
+            // fall through
+        case VALUE:
+            if (c == '{'){
+                if (!handler.StartObject()){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                stack.push_back(Container { true, 0 });
+                i++;
+                state = OBJECT_BEGIN;
+            } else if (c == '['){
+                if (!handler.StartArray()){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                stack.push_back(Container { false, 0 });
+                i++;
+                state = ARRAY_BEGIN;
+            } else if (c == '"'){
+                if (!parseString(handler, i, false)){
+                    return false;
+                }
+                i += 2;
+                state = AFTER_VALUE;
+            } else if (c == '}' || c == ']' || c == ':' || c == ','){
+                return setError(rapidjson::kParseErrorValueInvalid, pos);
+            } else {
+                if (!parseScalar(handler, i)){
+                    return false;
+                }
+                i++;
+                state = AFTER_VALUE;
+            }
+            break;
+        case AFTER_VALUE:
+        {
+            if (stack.empty()){
+                return setError(rapidjson::kParseErrorDocumentRootNotSingular, pos);
+            }
+            Container& top = stack.back();
+            top.count++;
+            if (c == ','){
+                i++;
+                state = top.isObject ? KEY : VALUE;
+            } else if (top.isObject && c == '}'){
+                rapidjson::SizeType count = top.count;
+                stack.pop_back();
+                if (!handler.EndObject(count)){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                i++;
+            } else if (!top.isObject && c == ']'){
+                rapidjson::SizeType count = top.count;
+                stack.pop_back();
+                if (!handler.EndArray(count)){
+                    return setError(rapidjson::kParseErrorTermination, pos);
+                }
+                i++;
+            } else {
+                return setError(top.isObject ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket
+                                             : rapidjson::kParseErrorArrayMissCommaOrSquareBracket, pos);
+            }
+            break;
+        }
+        }
+    }
+}
+
+/// the closing quote is always the next position
+template<typename Handler>
+inline bool ofxJsonStructuralIndex::parseString(Handler& handler, size_t index, bool isKey){
+    size_t begin = positions_[index];
+    size_t end = positions_[index + 1];
+    const char* str = data_ + begin + 1;
+    size_t length = end - begin - 1;
+    if (memchr(str, '\\', length)){
+        // let rapidjson unescape the string
+        rapidjson::MemoryStream ms(data_ + begin, end - begin + 1);
+        if (isKey){
+            KeyHandler<Handler> keyHandler(handler);
+            reader_.Parse<rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag>(ms, keyHandler);
+        } else {
+            reader_.Parse<rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag>(ms, handler);
+        }
+        if (reader_.HasParseError()){
+            return setError(reader_.GetParseErrorCode(), begin + reader_.GetErrorOffset());
+        }
+        return true;
+    }
+    bool result = isKey ? handler.Key(str, static_cast<rapidjson::SizeType>(length), true)
+                        : handler.String(str, static_cast<rapidjson::SizeType>(length), true);
+    return result || setError(rapidjson::kParseErrorTermination, begin);
+}
+
+/// numbers and literals extend to the next position (minus trailing whitespace)
+template<typename Handler>
+inline bool ofxJsonStructuralIndex::parseScalar(Handler& handler, size_t index){
+    size_t begin = positions_[index];
+    size_t end = (index + 1 < positions_.size()) ? positions_[index + 1] : size_;
+    while (end > begin){
+        char c = data_[end - 1];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t'){
+            break;
+        }
+        end--;
+    }
+    const char* str = data_ + begin;
+    size_t length = end - begin;
+    bool result;
+    if (length == 4 && !memcmp(str, "null", 4)){
+        result = handler.Null();
+    } else if (length == 4 && !memcmp(str, "true", 4)){
+        result = handler.Bool(true);
+    } else if (length == 5 && !memcmp(str, "false", 5)){
+        result = handler.Bool(false);
+    } else if (parseInteger(handler, str, length, result)){
+        // done
+    } else {
+        rapidjson::MemoryStream ms(str, length);
+        reader_.Parse<rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag>(ms, handler);
+        if (reader_.HasParseError()){
+            return setError(reader_.GetParseErrorCode(), begin + reader_.GetErrorOffset());
+        }
+        if (ms.Tell() != length){
+            return setError(rapidjson::kParseErrorValueInvalid, begin + ms.Tell());
+        }
+        return true;
+    }
+    return result || setError(rapidjson::kParseErrorTermination, begin);
+}
+
+/// integers with up to 18 digits (which can't overflow) are handled here,
+/// everything else goes through rapidjson's reader. returns false if 'str' isn't such an integer.
+template<typename Handler>
+inline bool ofxJsonStructuralIndex::parseInteger(Handler& handler, const char* str, size_t length, bool& result){
+    const char* end = str + length;
+    bool minus = (*str == '-');
+    if (minus){
+        str++;
+    }
+    size_t numDigits = end - str;
+    if (numDigits == 0 || numDigits > 18 || (*str == '0' && numDigits > 1)){
+        return false;
+    }
+    uint64_t value = 0;
+    for (const char* p = str; p != end; ++p){
+        unsigned digit = static_cast<unsigned char>(*p) - '0';
+        if (digit > 9){
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    // same types as rapidjson's reader
+    if (minus){
+        if (value <= 2147483648ULL){
+            result = handler.Int(static_cast<int>(-static_cast<int64_t>(value)));
+        } else {
+            result = handler.Int64(-static_cast<int64_t>(value));
+        }
+    } else {
+        if (value <= 4294967295ULL){
+            result = handler.Uint(static_cast<unsigned>(value));
+        } else {
+            result = handler.Uint64(value);
+        }
+    }
+    return true;
+}
+
+inline const vector<uint32_t>& ofxJsonStructuralIndex::getPositions() const {
+    return positions_;
+}
+
+inline rapidjson::ParseErrorCode ofxJsonStructuralIndex::getError() const {
+    return error_;
+}
+
+inline size_t ofxJsonStructuralIndex::getErrorOffset() const {
+    return errorOffset_;
+}
+
+inline const char* ofxJsonStructuralIndex::getKernelName(){
+    FindMasksFunction findMasks = getFindMasks();
+#ifdef OFX_JSON_AVX2
+    if (findMasks == findMasksAVX2){
+        return "AVX2";
+    }
+#endif
+#ifdef OFX_JSON_SSE2
+    if (findMasks == findMasksSSE2){
+        return "SSE2";
+    }
+#endif
+    return "scalar";
+}
+
+inline ofxJsonStructuralIndex::FindMasksFunction ofxJsonStructuralIndex::getFindMasks(){
+#ifdef RAPIDJSON_SIMD_DISPATCH
+    rapidjson::internal::SimdLevel level = rapidjson::internal::GetSimdLevel();
+    if (level >= rapidjson::internal::kSimdAVX2){
+        return findMasksAVX2;
+    } else if (level >= rapidjson::internal::kSimdSSE2){
+        return findMasksSSE2;
+    } else {
+        return findMasksScalar;
+    }
+#elif defined(OFX_JSON_AVX2)
+    return findMasksAVX2;
+#elif defined(OFX_JSON_SSE2)
+    return findMasksSSE2;
+#else
+    return findMasksScalar;
+#endif
+}
+
+/// one bit per byte for each character class
+#ifdef OFX_JSON_AVX2
+RAPIDJSON_TARGET("avx2") inline void ofxJsonStructuralIndex::findMasksAVX2(const char* block, Masks& masks){
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i openBrace = _mm256_set1_epi8('{'); // '[' | 0x20
+    const __m256i closeBrace = _mm256_set1_epi8('}'); // ']' | 0x20
+    const __m256i lowerCase = _mm256_set1_epi8(0x20);
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i maxControl = _mm256_set1_epi8(0x1f);
+    memset(&masks, 0, sizeof(masks));
+    for (int k = 0; k < 2; ++k){
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + k * 32));
+        const __m256i lower = _mm256_or_si256(s, lowerCase);
+        const __m256i op = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(lower, openBrace), _mm256_cmpeq_epi8(lower, closeBrace)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(s, colon), _mm256_cmpeq_epi8(s, comma)));
+        const __m256i ws = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(s, space), _mm256_cmpeq_epi8(s, tab)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(s, newline), _mm256_cmpeq_epi8(s, cr)));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(s, maxControl), maxControl); // s <= 0x1f
+        const int shift = k * 32;
+        masks.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, quote)))) << shift;
+        masks.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, backslash)))) << shift;
+        masks.op |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << shift;
+        masks.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << shift;
+        masks.control |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(control))) << shift;
+    }
+}
+#endif
+
+#ifdef OFX_JSON_SSE2
+RAPIDJSON_TARGET("sse2") inline void ofxJsonStructuralIndex::findMasksSSE2(const char* block, Masks& masks){
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i openBrace = _mm_set1_epi8('{'); // '[' | 0x20
+    const __m128i closeBrace = _mm_set1_epi8('}'); // ']' | 0x20
+    const __m128i lowerCase = _mm_set1_epi8(0x20);
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i maxControl = _mm_set1_epi8(0x1f);
+    memset(&masks, 0, sizeof(masks));
+    for (int k = 0; k < 4; ++k){
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k * 16));
+        const __m128i lower = _mm_or_si128(s, lowerCase);
+        const __m128i op = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(lower, openBrace), _mm_cmpeq_epi8(lower, closeBrace)),
+                    _mm_or_si128(_mm_cmpeq_epi8(s, colon), _mm_cmpeq_epi8(s, comma)));
+        const __m128i ws = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(s, space), _mm_cmpeq_epi8(s, tab)),
+                    _mm_or_si128(_mm_cmpeq_epi8(s, newline), _mm_cmpeq_epi8(s, cr)));
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(s, maxControl), maxControl); // s <= 0x1f
+        const int shift = k * 16;
+        masks.quote |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(s, quote))) << shift;
+        masks.backslash |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(s, backslash))) << shift;
+        masks.op |= static_cast<uint64_t>(_mm_movemask_epi8(op)) << shift;
+        masks.whitespace |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << shift;
+        masks.control |= static_cast<uint64_t>(_mm_movemask_epi8(control)) << shift;
+    }
+}
+#endif
+
+inline void ofxJsonStructuralIndex::findMasksScalar(const char* block, Masks& masks){
+    memset(&masks, 0, sizeof(masks));
+    for (int k = 0; k < 64; ++k){
+        uint64_t bit = static_cast<uint64_t>(1) << k;
+        unsigned char c = static_cast<unsigned char>(block[k]);
+        switch (c){
+        case '"':
+            masks.quote |= bit;
+            break;
+        case '\\':
+            masks.backslash |= bit;
+            break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            masks.op |= bit;
+            break;
+        case ' ':
+            masks.whitespace |= bit;
+            break;
+        case '\t': case '\n': case '\r':
+            masks.whitespace |= bit;
+            masks.control |= bit;
+            break;
+        default:
+            if (c < 0x20){
+                masks.control |= bit;
+            }
+            break;
+        }
+    }
+}
+
+/// characters preceded by an odd number of backslashes
+inline uint64_t ofxJsonStructuralIndex::findEscaped(uint64_t backslash, uint64_t& prevEscaped){
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    const uint64_t oddBits = ~evenBits;
+    uint64_t startEdges = backslash & ~(backslash << 1);
+    // a sequence continued from the previous block flips the parity
+    uint64_t evenStartMask = evenBits ^ prevEscaped;
+    uint64_t evenStarts = startEdges & evenStartMask;
+    uint64_t oddStarts = startEdges & ~evenStartMask;
+    uint64_t evenCarries = backslash + evenStarts;
+    uint64_t oddCarries = backslash + oddStarts;
+    bool overflow = oddCarries < backslash;
+    oddCarries |= prevEscaped;
+    prevEscaped = overflow ? 1 : 0;
+    uint64_t evenCarryEnds = evenCarries & ~backslash;
+    uint64_t oddCarryEnds = oddCarries & ~backslash;
+    return (evenCarryEnds & oddBits) | (oddCarryEnds & evenBits);
+}
+
+/// bit i = XOR of bits 0..i
+inline uint64_t ofxJsonStructuralIndex::prefixXor(uint64_t bits){
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+inline int ofxJsonStructuralIndex::countTrailingZeros(uint64_t bits){
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline bool ofxJsonStructuralIndex::setError(rapidjson::ParseErrorCode error, size_t offset){
+    error_ = error;
+    errorOffset_ = offset;
+    return false;
+}
+
+/*///////////// ofxJsonThreadCachingAllocator ////////////////////*/
+
+/// the free lists of one thread (for every allocator it has used)
+struct ofxJsonThreadCachingAllocator::ThreadCache {
+    struct Entry {
+        uint64_t id;
+        vector<void*> blocks;
+    };
+    vector<Entry> entries;
+    bool& alive;
+
+    ThreadCache(bool& alive) : alive(alive) {
+        alive = true;
+    }
+    ~ThreadCache(){
+        alive = false;
+        // the allocators might be gone already, but the blocks are plain heap memory
+        for (auto& entry : entries){
+            for (auto& block : entry.blocks){
+                std::free(block);
+            }
+        }
+    }
+};
+
+inline ofxJsonThreadCachingAllocator::ofxJsonThreadCachingAllocator(size_t chunkSize, size_t maxCached,
+                                                                    size_t maxShared, size_t hugePageThreshold)
+    : blockSize_(chunkSize + headerSize), maxCached_(maxCached), maxShared_(maxShared),
+      hugePageThreshold_(hugePageThreshold) {
+    static atomic<uint64_t> nextId(1);
+    id_ = nextId++;
+    shared_.reserve(maxShared); // Free() must not allocate
+}
+
+inline ofxJsonThreadCachingAllocator::~ofxJsonThreadCachingAllocator() {
+    // the cache of this thread may be gone already (static allocator)
+    for (auto& block : shared_){
+        std::free(block);
+    }
+}
+
+inline vector<void*>* ofxJsonThreadCachingAllocator::getCache(){
+    // documents may still be destroyed after the cache (e.g. static ones at exit)
+    static thread_local bool alive = false;
+    static thread_local ThreadCache cache(alive);
+    if (!alive){
+        return nullptr;
+    }
+    for (auto& entry : cache.entries){
+        if (entry.id == id_){
+            return &entry.blocks;
+        }
+    }
+    cache.entries.emplace_back();
+    cache.entries.back().id = id_;
+    cache.entries.back().blocks.reserve(maxCached_ + 1);
+    return &cache.entries.back().blocks;
+}
+
+inline void* ofxJsonThreadCachingAllocator::Malloc(size_t size){
+    auto cache = size <= blockSize_ ? getCache() : nullptr;
+    if (cache){
+        if (cache->empty()){
+            // refill half of the list at once, so the lock is taken rarely
+            lock_guard<mutex> lock(mutex_);
+            size_t n = std::min<size_t>(shared_.size(), std::max<size_t>(maxCached_ / 2, 1));
+            cache->insert(cache->end(), shared_.end() - n, shared_.end());
+            shared_.resize(shared_.size() - n);
+        }
+        if (!cache->empty()){
+            void* block = cache->back();
+            cache->pop_back();
+            return block;
+        }
+    }
+    if (size <= blockSize_){
+        return std::malloc(blockSize_);
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugePageThreshold_ && size >= hugePageThreshold_){
+        return allocateHugePages(size);
+    }
+#endif
+    return std::malloc(size);
+}
+
+inline void ofxJsonThreadCachingAllocator::Free(void* ptr, size_t size){
+    if (!ptr){
+        return;
+    }
+    auto cache = size <= blockSize_ ? getCache() : nullptr;
+    if (cache){
+        cache->push_back(ptr);
+        if (cache->size() > maxCached_){
+            // hand half of the list to the other threads, free what doesn't fit
+            size_t keep = maxCached_ / 2;
+            {
+                lock_guard<mutex> lock(mutex_);
+                while (cache->size() > keep && shared_.size() < maxShared_){
+                    shared_.push_back(cache->back());
+                    cache->pop_back();
+                }
+            }
+            while (cache->size() > keep){
+                std::free(cache->back());
+                cache->pop_back();
+            }
+        }
+        return;
+    }
+    if (size <= blockSize_){
+        std::free(ptr);
+        return;
+    }
+#ifdef MADV_HUGEPAGE
+    if (hugePageThreshold_ && size >= hugePageThreshold_){
+        freeHugePages(ptr, size);
+        return;
+    }
+#endif
+    std::free(ptr);
+}
+
+inline void ofxJsonThreadCachingAllocator::trim(){
+    if (auto cache = getCache()){
+        for (auto& block : *cache){
+            std::free(block);
+        }
+        cache->clear();
+    }
+    lock_guard<mutex> lock(mutex_);
+    for (auto& block : shared_){
+        std::free(block);
+    }
+    shared_.clear();
+}
+
+inline ofxJsonThreadCachingAllocator& ofxJsonThreadCachingAllocator::getDefault(){
+    static ofxJsonThreadCachingAllocator allocator;
+    return allocator;
+}
+
+#ifdef MADV_HUGEPAGE
+inline void* ofxJsonThreadCachingAllocator::allocateHugePages(size_t size){
+    size_t length = (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+    // map one more huge page, so the region can be aligned to a huge page boundary
+    char* region = static_cast<char*>(mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANON, -1, 0));
+    if (region == MAP_FAILED){
+        return nullptr;
+    }
+    size_t head = (hugePageSize - reinterpret_cast<uintptr_t>(region) % hugePageSize) % hugePageSize;
+    if (head){
+        munmap(region, head);
+    }
+    if (hugePageSize - head){
+        munmap(region + head + length, hugePageSize - head);
+    }
+    madvise(region + head, length, MADV_HUGEPAGE); // only a hint
+    return region + head;
+}
+
+inline void ofxJsonThreadCachingAllocator::freeHugePages(void* ptr, size_t size){
+    munmap(ptr, (size + hugePageSize - 1) / hugePageSize * hugePageSize);
+}
+#endif
+
+/*///////////// ofxJsonDocument ////////////////////*/
+
+/// constructors
+inline ofxJsonDocument::ofxJsonDocument()
+    : allocator_(nullptr), allocatorInBuffer_(false), document_() {}
+
+inline ofxJsonDocument::ofxJsonDocument(size_t chunkSize, ofxJsonBaseAllocator* baseAllocator)
+    : allocator_(new Allocator(chunkSize)), allocatorInBuffer_(false), document_(allocator_) {
+    allocator_->SetChunkAllocator(baseAllocator);
+}
+
+inline ofxJsonDocument::ofxJsonDocument(void* buffer, size_t size, size_t chunkSize, ofxJsonBaseAllocator* baseAllocator)
+    : allocator_(createAllocator(buffer, size, chunkSize, allocatorInBuffer_)), // sets allocatorInBuffer_ (not in this list!)
+      document_(allocator_) {
+    if (allocatorInBuffer_){
+        // the parse stacks follow the allocator (see createAllocator()), a quarter decodes strings
+        char* stack = reinterpret_cast<char*>(allocator_) + RAPIDJSON_ALIGN(sizeof(Allocator));
+        size_t stackSize = RAPIDJSON_ALIGN(size / 8);
+        size_t readerSize = RAPIDJSON_ALIGN(stackSize / 4);
+        document_.SetStackBuffer(stack, stackSize - readerSize, stack + stackSize - readerSize, readerSize);
+    }
+    allocator_->SetChunkAllocator(baseAllocator);
+}
+
+inline ofxJsonDocument::ofxJsonDocument(const ofxJsonDocument& mom)
+    : allocator_(nullptr), allocatorInBuffer_(false), document_(),
+      mappedFile_(mom.mappedFile_), maxDecimalPlaces_(mom.maxDecimalPlaces_) { // the copy shares in-situ strings
+    document_.CopyFrom(mom.document_, document_.GetAllocator());
+}
+
+inline ofxJsonDocument::ofxJsonDocument(ofxJsonDocument&& mom)
+    : allocator_(mom.allocator_), allocatorInBuffer_(mom.allocatorInBuffer_), document_(std::move(mom.document_)),
+      mappedFile_(std::move(mom.mappedFile_)), maxDecimalPlaces_(mom.maxDecimalPlaces_), saveQueue_(std::move(mom.saveQueue_)),
+      recycle_(mom.recycle_) { // the document keeps its stacks
+    mom.allocator_ = nullptr;
+}
+
+inline ofxJsonDocument::~ofxJsonDocument() {
+    destroyAllocator(); // the values don't need to be freed
+}
+
+/// layout of a user buffer: allocator | parse stacks (1/8) | first chunk of the pool.
+/// 'inBuffer' tells if the allocator has been placed in the buffer (otherwise it's on the heap).
+inline ofxJsonDocument::Allocator* ofxJsonDocument::createAllocator(void* buffer, size_t size, size_t chunkSize, bool& inBuffer){
+    uintptr_t address = reinterpret_cast<uintptr_t>(buffer);
+    size_t padding = RAPIDJSON_ALIGN(address) - address;
+    size_t header = RAPIDJSON_ALIGN(sizeof(Allocator)) + RAPIDJSON_ALIGN(size / 8);
+    if (!buffer || size < padding + header + 256){
+        ofLogWarning("ofxJsonDocument") << "buffer too small, using the heap!\n";
+        inBuffer = false;
+        return new Allocator(chunkSize);
+    }
+    char* p = static_cast<char*>(buffer) + padding;
+    inBuffer = true;
+    return new (p) Allocator(p + header, size - padding - header, chunkSize);
+}
+
+inline void ofxJsonDocument::destroyAllocator(){
+    if (allocator_){
+        if (allocatorInBuffer_){
+            allocator_->~Allocator(); // frees the chunks after the buffer
+        } else {
+            delete allocator_;
+        }
+        allocator_ = nullptr;
+    }
+}
+
+/// assignment
+inline ofxJsonDocument& ofxJsonDocument::operator =(const ofxJsonDocument& mom){
+    if (this != &mom){
+        if (recycle_){
+            clear();
+        }
+        document_.CopyFrom(mom.document_, document_.GetAllocator());
+        mappedFile_ = mom.mappedFile_;
+        maxDecimalPlaces_ = mom.maxDecimalPlaces_;
+    }
+    return *this;
+}
+
+inline ofxJsonDocument& ofxJsonDocument::operator =(ofxJsonDocument&& mom){
+    if (this != &mom){
+        document_ = std::move(mom.document_);
+        destroyAllocator();
+        allocator_ = mom.allocator_;
+        allocatorInBuffer_ = mom.allocatorInBuffer_;
+        mom.allocator_ = nullptr;
+        mappedFile_ = std::move(mom.mappedFile_);
+        maxDecimalPlaces_ = mom.maxDecimalPlaces_;
+        saveQueue_ = std::move(mom.saveQueue_);
+        recycle_ = mom.recycle_;
+    }
+
+    return *this;
+}
+
+/// loading JSON data
+inline bool ofxJsonDocument::loadFromFile(const string& path, size_t bufferSize){
+    ifstream ifs(path, ios::binary);
+
+    if (!ifs.is_open()){
+        ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
+        return false;
+    }
+
+    return loadFromStream(ifs, bufferSize);
+}
+
+inline bool ofxJsonDocument::loadFromStream(istream& is, size_t bufferSize){
+    if (recycle_){
+        clear();
+    }
+    ofxJsonBufferedIStream bis(is, bufferSize);
+    document_.ParseStream(bis);
+    if (document_.HasParseError()){
+        printError(document_.GetParseError(), document_.GetErrorOffset());
+        return false;
+    } else {
+        mappedFile_.reset();
+        return true;
+    }
+}
+
+/// asynchronous loading
+inline ofxJsonLoadHandle ofxJsonDocument::loadFromFileAsync(const string& path, ofxJsonThreadPool& pool){
+    auto state = make_shared<ofxJsonLoadState>();
+    state->pool = &pool;
+    pool.push([state, path](){
+        if (state->cancelled.load()){
+            state->finish(false, "cancelled");
+            return;
+        }
+        // the handle must always be finished, otherwise wait() never returns
+        try {
+            ifstream ifs(path, ios::binary);
+            if (!ifs.is_open()){
+                ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
+                state->finish(false, "couldn't open file");
+                return;
+            }
+            // get the file size for progress report (not available for pipes)
+            ifs.seekg(0, ios::end);
+            auto size = ifs.tellg();
+            ifs.seekg(0, ios::beg);
+            if (size > 0){
+                state->bytesTotal.store(size);
+            } else {
+                ifs.clear();
+            }
+
+            ofxJsonBufferedIStream bis(ifs);
+            loadAsync(*state, bis);
+        } catch (const exception& e){
+            ofLogWarning("ofxJsonDocument") << "couldn't load file: " << e.what() << "\n";
+            state->finish(false, e.what());
+        } catch (...){
+            state->finish(false, "unknown exception"); // e.g. a throwing RAPIDJSON_ASSERT
+        }
+    });
+    return ofxJsonLoadHandle(state);
+}
+
+inline ofxJsonLoadHandle ofxJsonDocument::loadFromBufferAsync(string buffer, ofxJsonThreadPool& pool){
+    auto state = make_shared<ofxJsonLoadState>();
+    state->pool = &pool;
+    auto data = make_shared<string>(std::move(buffer));
+    state->bytesTotal.store(data->size());
+    pool.push([state, data](){
+        if (state->cancelled.load()){
+            state->finish(false, "cancelled");
+            return;
+        }
+        try {
+            rapidjson::MemoryStream ms(data->data(), data->size());
+            loadAsync(*state, ms);
+        } catch (const exception& e){
+            ofLogWarning("ofxJsonDocument") << "couldn't load buffer: " << e.what() << "\n";
+            state->finish(false, e.what());
+        } catch (...){
+            state->finish(false, "unknown exception");
+        }
+    });
+    return ofxJsonLoadHandle(state);
+}
+
+inline ofxJsonLoadHandle ofxJsonDocument::loadFromBufferAsync(const ofBuffer& buffer, ofxJsonThreadPool& pool){
+    return loadFromBufferAsync(string(buffer.getData(), buffer.size()), pool);
+}
+
+/// load many files
+inline bool ofxJsonDocument::loadFromFiles(const vector<string>& paths, vector<ofxJsonDocument>& documents,
+                                           vector<string>& errors, ofxJsonThreadPool& pool){
+    documents.clear();
+    documents.resize(paths.size());
+    errors.assign(paths.size(), string());
+
+    mutex mtx;
+    condition_variable condition;
+    size_t remaining = paths.size();
+    bool result = true;
+
+    for (size_t i = 0; i < paths.size(); ++i){
+        // the tasks refer to our local variables, so they must always count down 'remaining'
+        pool.push([&, i](){
+            string error;
+            try {
+                error = loadFromFileBatched(documents[i], paths[i]);
+            } catch (const exception& e){
+                error = e.what(); // e.g. bad_alloc for a huge file
+            } catch (...){
+                error = "unknown exception";
+            }
+            lock_guard<mutex> lock(mtx);
+            if (!error.empty()){
+                ofLogWarning("ofxJsonDocument") << paths[i] << ": " << error << "\n";
+                errors[i] = std::move(error);
+                result = false;
+            }
+            if (--remaining == 0){
+                condition.notify_one();
+            }
+        });
+    }
+
+    // help with our own (or other) tasks; once the queues are empty
+    // all our remaining tasks are running on other threads.
+    unique_lock<mutex> lock(mtx);
+    while (remaining > 0){
+        lock.unlock();
+        bool ran;
+        try {
+            ran = pool.runPendingTask();
+        } catch (...){
+            // a foreign task has thrown; our tasks still refer to the local variables
+            lock.lock();
+            condition.wait(lock, [&](){ return remaining == 0; });
+            throw;
+        }
+        lock.lock();
+        if (!ran){
+            condition.wait(lock, [&](){ return remaining == 0; });
+        }
+    }
+    return result;
+}
+
+/// load a single file of a batch; returns an error message on failure.
+/// the read buffer and the reader (with its parse stack) are reused by every file of the same thread.
+/// read buffers larger than 'maxKeep' are released after the file, so a single huge file
+/// doesn't pin its size for the lifetime of the thread.
+inline string ofxJsonDocument::loadFromFileBatched(ofxJsonDocument& document, const string& path){
+    struct Context {
+        vector<char> buffer;
+        rapidjson::Reader reader;
+    };
+    static thread_local Context context;
+    struct Shrink {
+        vector<char>& buffer;
+        ~Shrink(){
+            const size_t maxKeep = 16 * 1024 * 1024;
+            if (buffer.capacity() > maxKeep){
+                vector<char>().swap(buffer);
+            }
+        }
+    } shrink { context.buffer };
+
+    ifstream ifs(path, ios::binary);
+    if (!ifs.is_open()){
+        return "couldn't open file";
+    }
+    ifs.seekg(0, ios::end);
+    auto size = ifs.tellg();
+    ifs.seekg(0, ios::beg);
+
+    // parse with our own reader, so its stack can be reused
+    rapidjson::ParseResult result;
+    if (size >= 0){
+        context.buffer.resize(size);
+        ifs.read(context.buffer.data(), size);
+        rapidjson::MemoryStream ms(context.buffer.data(), ifs.gcount());
+        rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(ms);
+        auto generator = [&](rapidjson::Document& doc){
+            result = context.reader.Parse(is, doc);
+            return !result.IsError();
+        };
+        document.document_.Populate(generator);
+    } else {
+        // size not available -> read in blocks
+        ifs.clear();
+        ofxJsonBufferedIStream is(ifs);
+        auto generator = [&](rapidjson::Document& doc){
+            result = context.reader.Parse(is, doc);
+            return !result.IsError();
+        };
+        document.document_.Populate(generator);
+    }
+
+    if (result.IsError()){
+        return string(rapidjson::GetParseError_En(result.Code())) + " [" + to_string(result.Offset()) + "]";
+    } else {
+        return string();
+    }
+}
+
+/// parse on the worker thread
+template<typename InputStream>
+inline void ofxJsonDocument::loadAsync(ofxJsonLoadState& state, InputStream& is){
+    rapidjson::Document& doc = state.document.document_;
+    ofxJsonProgressHandler<InputStream> handler(doc, is, state.bytesConsumed, state.cancelled);
+    rapidjson::ParseResult result;
+    auto generator = [&](rapidjson::Document&){
+        rapidjson::Reader reader;
+        result = reader.Parse(is, handler);
+        return !result.IsError();
+    };
+    doc.Populate(generator);
+    state.bytesConsumed.store(is.Tell());
+    if (result.IsError()){
+        if (handler.isStopped()){
+            state.finish(false, "cancelled");
+        } else {
+            state.document.printError(result.Code(), result.Offset());
+            state.finish(false, string(rapidjson::GetParseError_En(result.Code()))
+                         + " [" + to_string(result.Offset()) + "]");
+        }
+    } else {
+        state.finish(true, "");
+    }
+}
+
+inline bool ofxJsonDocument::loadFromFileMapped(const string& path){
+    auto file = make_shared<ofxJsonMappedFile>();
+
+    if (!file->open(path)){
+        // can't be mapped (e.g. a pipe or not supported on this platform)
+        return loadFromFile(path);
+    }
+
+    if (recycle_){
+        clear();
+    }
+    document_.ParseInsitu(file->getData());
+    if (document_.HasParseError()){
+        printError(document_.GetParseError(), document_.GetErrorOffset());
+        return false;
+    } else {
+        mappedFile_ = file; // strings point into the mapping now
+        return true;
+    }
+}
+
+inline bool ofxJsonDocument::loadFromBuffer(const char *data, size_t size, ofxJsonParseMode mode){
+    if (recycle_){
+        clear();
+    }
+    if (mode == OFX_JSON_PARSE_INDEXED && size <= ofxJsonStructuralIndex::maxSize){
+        ofxJsonStructuralIndex index;
+        bool result = index.build(data, size);
+        if (result){
+            auto generator = [&](rapidjson::Document& handler){
+                result = index.parse(handler);
+                return result;
+            };
+            document_.Populate(generator);
+        }
+        if (!result){
+            printError(index.getError(), index.getErrorOffset());
+            return false;
+        }
+        mappedFile_.reset();
+        return true;
+    }
+
+    document_.Parse(data, size);
+    if (document_.HasParseError()){
+        printError(document_.GetParseError(), document_.GetErrorOffset());
+        return false;
+    } else {
+        mappedFile_.reset();
+        return true;
+    }
+}
+
+inline bool ofxJsonDocument::loadFromBuffer(const string& buffer, ofxJsonParseMode mode){
+    return loadFromBuffer(buffer.data(), buffer.size(), mode);
+}
+
+inline bool ofxJsonDocument::loadFromBuffer(const ofBuffer& buffer, ofxJsonParseMode mode){
+    return loadFromBuffer(buffer.getData(), buffer.size(), mode);
+}
+
+/// saving JSON data
+inline bool ofxJsonDocument::saveToFile(const string& path, bool pretty, bool atomic){
+    ofxJsonFileOStream os;
+
+    if (!os.open(path, atomic)){
+        ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
+        return false;
+    }
+
+    if (!write(os, pretty)){
+        os.discard(); // e.g. NaN, don't replace an atomic file with garbage
+        return false;
+    }
+    if (!os.close()){
+        ofLogWarning("ofxJsonDocument") << "couldn't write file!\n";
+        return false;
+    }
+    return true;
+}
+
+/// save to binary buffer
+
+template<typename OutputStream>
+inline bool ofxJsonDocument::write(OutputStream& os, bool pretty) const {
+    if (pretty){
+        rapidjson::PrettyWriter<OutputStream> writer(os);
+        writer.SetMaxDecimalPlaces(maxDecimalPlaces_);
+        return document_.Accept(writer);
+    } else {
+        rapidjson::Writer<OutputStream> writer(os);
+        writer.SetMaxDecimalPlaces(maxDecimalPlaces_);
+        return document_.Accept(writer);
+    }
+}
+
+/// save on a worker thread
+inline ofxJsonSaveHandle ofxJsonDocument::saveToFileAsync(const string& path, bool pretty, bool atomic, ofxJsonThreadPool& pool){
+    auto state = make_shared<ofxJsonSaveState>();
+    state->requestTime = chrono::steady_clock::now();
+
+    auto job = make_shared<ofxJsonSaveJob>();
+    job->snapshot = *this; // deep copy (in-situ strings are shared)
+    job->path = path;
+    job->pretty = pretty;
+    job->atomic = atomic;
+    job->states.push_back(state);
+    state->snapshotTime = chrono::duration<double, milli>(chrono::steady_clock::now() - state->requestTime).count();
+
+    if (!saveQueue_){
+        saveQueue_ = make_shared<ofxJsonSaveQueue>();
+    }
+    bool start = false;
+    {
+        lock_guard<mutex> lock(saveQueue_->mtx);
+        auto& jobs = saveQueue_->jobs;
+        if (!jobs.empty() && jobs.back()->path == path){
+            // the worker hasn't started on the previous snapshot yet -> replace it
+            for (auto& s : jobs.back()->states){
+                s->coalesced.store(true);
+                job->states.push_back(s);
+            }
+            jobs.back() = job;
+        } else {
+            jobs.push_back(job);
+        }
+        if (!saveQueue_->running){
+            saveQueue_->running = true;
+            start = true;
+        }
+    }
+    if (start){
+        auto queue = saveQueue_;
+        pool.push([queue](){ saveAsync(*queue); });
+    }
+    return ofxJsonSaveHandle(state);
+}
+
+inline void ofxJsonDocument::saveAsync(ofxJsonSaveQueue& queue){
+    for (;;){
+        shared_ptr<ofxJsonSaveJob> job;
+        {
+            lock_guard<mutex> lock(queue.mtx);
+            if (queue.jobs.empty()){
+                queue.running = false;
+                return;
+            }
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+
+        string error;
+        ofxJsonFileOStream os;
+        if (!os.open(job->path, job->atomic)){
+            ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
+            error = "couldn't open file";
+        } else if (!job->snapshot.write(os, job->pretty)){
+            os.discard();
+            error = "couldn't serialize document";
+        } else if (!os.close()){
+            ofLogWarning("ofxJsonDocument") << "couldn't write file!\n";
+            error = "couldn't write file";
+        }
+        for (auto& state : job->states){
+            state->finish(error.empty(), error, error.empty() ? os.size() : 0);
+        }
+    }
+}
+
+inline bool ofxJsonDocument::saveToBuffer(string& buffer, bool pretty){
+    ofxJsonBufferOStream<string> os(buffer);
+    if (write(os, pretty)){
+        os.finish();
+        return true;
+    } else {
+        buffer.clear(); // don't leave truncated JSON behind
+        return false;
+    }
+}
+
+inline bool ofxJsonDocument::saveToBuffer(ofBuffer& buffer, bool pretty){
+    ofxJsonBufferOStream<ofBuffer> os(buffer);
+    if (write(os, pretty)){
+        os.finish();
+        return true;
+    } else {
+        buffer.clear(); // don't leave truncated JSON behind
+        return false;
+    }
+}
+
+inline bool ofxJsonDocument::saveToBuffer(char* data, size_t capacity, size_t& size, bool pretty){
+    ofxJsonMemoryOStream os(data, capacity);
+    if (!write(os, pretty)){
+        size = 0; // can't be serialized at all (see serializedSize())
+        return false;
+    }
+    size = os.size();
+    return !os.isFull();
+}
+
+inline bool ofxJsonDocument::saveToBuffer(ofxJsonSegmentedOStream& buffer, bool pretty){
+    return write(buffer, pretty);
+}
+
+inline size_t ofxJsonDocument::serializedSize(bool pretty) const {
+    ofxJsonCountingOStream os;
+    return write(os, pretty) ? os.size() : 0;
+}
+
+inline ofxJsonBufferView ofxJsonDocument::saveToView(bool pretty){
+    // the buffer isn't trimmed, so the next call doesn't need to grow it again
+    ofxJsonStringOStream os(saveBuffer_);
+    if (write(os, pretty)){
+        return ofxJsonBufferView(os.data(), os.size());
+    } else {
+        return ofxJsonBufferView();
+    }
+}
+
+inline void ofxJsonDocument::setMaxDecimalPlaces(int places){
+    maxDecimalPlaces_ = places;
+}
+
+inline int ofxJsonDocument::getMaxDecimalPlaces() const {
+    return maxDecimalPlaces_;
+}
+
+inline void ofxJsonDocument::setRecycleMode(bool recycle){
+    recycle_ = recycle;
+    document_.KeepStackCapacity(recycle);
+}
+
+inline bool ofxJsonDocument::getRecycleMode() const {
+    return recycle_;
+}
+
+inline void ofxJsonDocument::clear(){
+    if (recycle_){
+        document_.SetNull();
+        document_.GetAllocator().Recycle(); // keeps the chunks
+        mappedFile_.reset();
+    } else {
+        document_.Clear();
+    }
+}
+
+inline ofxJsonMemoryStats ofxJsonDocument::getMemoryStats() const {
+    ofxJsonMemoryStats stats;
+    const Allocator& allocator = document_.GetAllocator();
+    stats.numChunks = allocator.ChunkCount();
+    stats.capacity = allocator.Capacity();
+    stats.numRecycledChunks = allocator.RecycledChunkCount(&stats.recycledCapacity);
+    stats.size = allocator.Size();
+#if RAPIDJSON_STATS
+    stats.enabled = true;
+    stats.bytesRequested = allocator.GetStats().requested;
+    stats.bytesWasted = allocator.GetStats().wasted;
+    stats.peakSize = allocator.GetStats().peak;
+    stats.stackHighWater = document_.GetStackHighWater();
+    stats.readerStackHighWater = document_.GetReaderStackHighWater();
+#endif
+    return stats;
+}
+
+inline void ofxJsonDocument::resetMemoryStats(){
+#if RAPIDJSON_STATS
+    document_.GetAllocator().ResetPeak();
+    document_.ResetStackHighWater();
+#endif
+}
+
+inline size_t ofxJsonDocument::compact(){
+    Allocator& allocator = document_.GetAllocator();
+    size_t recycled = 0;
+    allocator.RecycledChunkCount(&recycled);
+    size_t before = allocator.Capacity() + recycled;
+    {
+        // copy into a single temporary chunk and back into the emptied pool,
+        // which keeps its user buffer, chunk size and base allocator
+        Allocator temp(std::max<size_t>(allocator.Size(), 1));
+        temp.SetChunkAllocator(allocator.GetChunkAllocator());
+        rapidjson::Value copy(static_cast<const rapidjson::Value&>(document_), temp);
+        document_.SetNull();
+        allocator.Clear();
+        document_.CopyFrom(copy, allocator);
+    }
+    size_t after = allocator.Capacity();
+    return before > after ? before - after : 0;
+}
+
+/// find value by key
+inline ofxJsonValueIterator ofxJsonDocument::find(const string& key){
+    rapidjson::Pointer ptr(key.data(), key.size());
+    return ofxJsonValueIterator(ptr.Get(document_), document_.GetAllocator());
+}
+
+/// find value by key
+inline ofxJsonValueIterator ofxJsonDocument::end(){
+    return ofxJsonValueIterator(nullptr, document_.GetAllocator());
+}
+
+inline ofxJsonValueRef ofxJsonDocument::operator[](const string& key) {
+    rapidjson::Pointer ptr(key.data(), key.size());
+    rapidjson::Value* value = ptr.Get(document_);
+    if (value){
+        return ofxJsonValueRef(*value, document_.GetAllocator());
+    } else {
+        return ofxJsonValueRef(ptr.Create(document_), document_.GetAllocator());
+    }
+}
+
+/// get root value reference
+inline ofxJsonValueRef ofxJsonDocument::getRoot(){
+    return ofxJsonValueRef(document_, document_.GetAllocator());
+}
+
+/// get document
+inline rapidjson::Document& ofxJsonDocument::getDocument(){
+    return document_;
+}
+
+/// print parse error
+inline void ofxJsonDocument::printError(rapidjson::ParseErrorCode error, size_t offset){
+    ofLogWarning("ofxJsonDocument") << rapidjson::GetParseError_En(error) << " [" << offset << "]\n";
+}
+
+
+/*///////////////////// ofxJsonDocumentPool /////////////////*/
+
+inline ofxJsonDocumentPool::ofxJsonDocumentPool(size_t maxFree, size_t chunkSize)
+    : maxFree_(maxFree), chunkSize_(chunkSize) {
+    free_.reserve(maxFree); // release() must not allocate
+}
+
+inline ofxJsonDocumentPool::~ofxJsonDocumentPool() {
+    trim();
+}
+
+inline ofxJsonDocumentPool::Ptr ofxJsonDocumentPool::acquire(){
+    ofxJsonDocument* document = nullptr;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!free_.empty()){
+            document = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (!document){
+        document = new ofxJsonDocument(chunkSize_);
+        document->setRecycleMode(true);
+    }
+    return Ptr(document, Deleter{ this });
+}
+
+inline void ofxJsonDocumentPool::release(ofxJsonDocument* document){
+    document->setRecycleMode(true); // in case it has been turned off
+    document->clear();
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (free_.size() < maxFree_){
+            free_.push_back(document);
+            return;
+        }
+    }
+    delete document;
+}
+
+inline void ofxJsonDocumentPool::trim(){
+    lock_guard<mutex> lock(mutex_);
+    for (auto& document : free_){
+        delete document;
+    }
+    free_.clear();
+}
+
+inline ofxJsonDocumentPool& ofxJsonDocumentPool::getDefault(){
+    static ofxJsonDocumentPool pool;
+    return pool;
+}
+
+/*///////////////////// ofxJsonLoadHandle /////////////////*/
+
+inline void ofxJsonLoadState::finish(bool res, const string& err){
+    {
+        lock_guard<mutex> lock(mtx);
+        done = true;
+        result = res;
+        error = err;
+    }
+    condition.notify_all();
+}
+
+inline bool ofxJsonLoadHandle::isValid() const {
+    return state_ != nullptr;
+}
+
+inline bool ofxJsonLoadHandle::isReady() const {
+    if (!state_){
+        return true;
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->done;
+}
+
+inline void ofxJsonLoadHandle::wait() const {
+    if (!state_){
+        return;
+    }
+    if (state_->pool && state_->pool->isWorkerThread()){
+        // run queued tasks (possibly our own) instead of blocking a worker
+        while (!isReady() && state_->pool->runPendingTask()) {}
+    }
+    unique_lock<mutex> lock(state_->mtx);
+    ofxJsonLoadState* state = state_.get();
+    state_->condition.wait(lock, [state](){ return state->done; });
+}
+
+inline bool ofxJsonLoadHandle::waitFor(int ms) const {
+    if (!state_){
+        return true;
+    }
+    unique_lock<mutex> lock(state_->mtx);
+    ofxJsonLoadState* state = state_.get();
+    return state_->condition.wait_for(lock, chrono::milliseconds(ms), [state](){ return state->done; });
+}
+
+inline size_t ofxJsonLoadHandle::getBytesConsumed() const {
+    return state_ ? state_->bytesConsumed.load() : 0;
+}
+
+inline size_t ofxJsonLoadHandle::getBytesTotal() const {
+    return state_ ? state_->bytesTotal.load() : 0;
+}
+
+inline float ofxJsonLoadHandle::getProgress() const {
+    size_t total = getBytesTotal();
+    if (total > 0){
+        return std::min<float>(static_cast<float>(getBytesConsumed()) / total, 1.f);
+    } else {
+        return 0;
+    }
+}
+
+inline void ofxJsonLoadHandle::cancel(){
+    if (state_){
+        state_->cancelled.store(true);
+    }
+}
+
+inline bool ofxJsonLoadHandle::isCancelled() const {
+    return state_ && state_->cancelled.load();
+}
+
+inline bool ofxJsonLoadHandle::get(ofxJsonDocument& document){
+    if (!state_){
+        ofLogWarning("ofxJsonLoadHandle") << "invalid handle!\n";
+        return false;
+    }
+    wait();
+    if (state_->result){
+        document = std::move(state_->document); // hand over without copying
+        return true;
+    } else {
+        return false;
+    }
+}
+
+inline string ofxJsonLoadHandle::getError() const {
+    if (!state_){
+        return "invalid handle";
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->error;
+}
+
+/*///////////////////// ofxJsonSaveHandle /////////////////*/
+
+inline void ofxJsonSaveState::finish(bool res, const string& err, size_t bytes){
+    {
+        lock_guard<mutex> lock(mtx);
+        done = true;
+        result = res;
+        error = err;
+        bytesWritten = bytes;
+        latency = chrono::duration<double, milli>(chrono::steady_clock::now() - requestTime).count();
+    }
+    condition.notify_all();
+}
+
+inline bool ofxJsonSaveHandle::isValid() const {
+    return state_ != nullptr;
+}
+
+inline bool ofxJsonSaveHandle::isReady() const {
+    if (!state_){
+        return true;
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->done;
+}
+
+inline void ofxJsonSaveHandle::wait() const {
+    if (!state_){
+        return;
+    }
+    unique_lock<mutex> lock(state_->mtx);
+    ofxJsonSaveState* state = state_.get();
+    state_->condition.wait(lock, [state](){ return state->done; });
+}
+
+inline bool ofxJsonSaveHandle::waitFor(int ms) const {
+    if (!state_){
+        return true;
+    }
+    unique_lock<mutex> lock(state_->mtx);
+    ofxJsonSaveState* state = state_.get();
+    return state_->condition.wait_for(lock, chrono::milliseconds(ms), [state](){ return state->done; });
+}
+
+inline bool ofxJsonSaveHandle::getResult() const {
+    if (!state_){
+        ofLogWarning("ofxJsonSaveHandle") << "invalid handle!\n";
+        return false;
+    }
+    wait();
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->result;
+}
+
+inline string ofxJsonSaveHandle::getError() const {
+    if (!state_){
+        return "invalid handle";
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->error;
+}
+
+inline bool ofxJsonSaveHandle::isCoalesced() const {
+    return state_ && state_->coalesced.load();
+}
+
+inline double ofxJsonSaveHandle::getSnapshotTime() const {
+    return state_ ? state_->snapshotTime : 0; // set before the handle is returned
+}
+
+inline double ofxJsonSaveHandle::getLatency() const {
+    if (!state_){
+        return 0;
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->latency;
+}
+
+inline size_t ofxJsonSaveHandle::getBytesWritten() const {
+    if (!state_){
+        return 0;
+    }
+    lock_guard<mutex> lock(state_->mtx);
+    return state_->bytesWritten;
+}
+
+/*///////////////////// ofxJsonLinesReader /////////////////*/
+
+inline ofxJsonLinesReader::ofxJsonLinesReader()
+    : numRecords_(0), numErrors_(0) {
+    record_.setRecycleMode(true);
+}
+
+inline ofxJsonLinesReader::~ofxJsonLinesReader() {}
+
+inline bool ofxJsonLinesReader::open(const string& path, size_t bufferSize){
+    close();
+    unique_ptr<ifstream> file(new ifstream(path, ios::binary));
+
+    if (!file->is_open()){
+        ofLogWarning("ofxJsonLinesReader") << "couldn't open file!\n";
+        return false;
+    }
+
+    stream_.reset(new ofxJsonBufferedIStream(*file, bufferSize));
+    file_ = std::move(file);
+    return true;
+}
+
+inline bool ofxJsonLinesReader::open(istream& is, size_t bufferSize){
+    close();
+    stream_.reset(new ofxJsonBufferedIStream(is, bufferSize));
+    return true;
+}
+
+inline void ofxJsonLinesReader::close(){
+    stream_.reset();
+    file_.reset();
+    numRecords_ = 0;
+    numErrors_ = 0;
+}
+
+inline bool ofxJsonLinesReader::isOpen() const {
+    return stream_ != nullptr;
+}
+
+inline bool ofxJsonLinesReader::next(){
+    return readRecord(record_);
+}
+
+inline ofxJsonDocument& ofxJsonLinesReader::getRecord(){
+    return record_;
+}
+
+inline size_t ofxJsonLinesReader::nextBatch(vector<ofxJsonDocument>& records, size_t count){
+    if (records.size() < count){
+        records.resize(count);
+    }
+    size_t n = 0;
+    while (n < count && readRecord(records[n])){
+        ++n;
+    }
+    records.resize(n);
+    return n;
+}
+
+inline size_t ofxJsonLinesReader::readParallel(const string& path, const function<void(ofxJsonValueRef)>& callback,
+                                               bool ordered, size_t chunkSize, ofxJsonThreadPool& pool){
+    ofxJsonMappedFile file;
+    if (!file.open(path)){
+        // can't be mapped -> read sequentially
+        if (!open(path)){
+            return 0;
+        }
+        while (next()){
+            callback(record_.getRoot());
+        }
+        size_t result = numRecords_;
+        file_.reset();
+        stream_.reset();
+        return result;
+    }
+    close();
+
+    // a chunk of lines; in ordered mode it also keeps the parsed records until they are passed to the callback
+    struct Chunk {
+        const char* data;
+        size_t size;
+        size_t offset;
+        rapidjson::MemoryPoolAllocator<> allocator;
+        rapidjson::Value records;
+        size_t numRecords = 0;
+        size_t numErrors = 0;
+        exception_ptr error; // thrown by the callback on a worker thread
+        bool done = false;
+    };
+    // per thread document and allocator for parsing single records.
+    // the user buffer is kept by MemoryPoolAllocator::Clear(), so small records never touch the heap.
+    struct Context {
+        Context() : buffer(256 * 1024), allocator(buffer.data(), buffer.size()), document(&allocator) {
+            document.KeepStackCapacity(true);
+        }
+        vector<char> buffer;
+        rapidjson::MemoryPoolAllocator<> allocator;
+        rapidjson::Document document;
+    };
+
+    mutex mtx;
+    condition_variable condition;
+    deque<unique_ptr<Chunk>> chunks; // in flight
+    atomic<bool> cancelled{false};
+    const size_t maxChunks = 2 * pool.getNumThreads();
+    const char* data = file.getData();
+    const size_t size = file.size();
+    size_t offset = 0;
+
+    try {
+        while (offset < size || !chunks.empty()){
+            // queue new chunks
+            while (offset < size && chunks.size() < maxChunks){
+                // split after the first newline following 'chunkSize' bytes
+                size_t end = std::min(offset + std::max<size_t>(chunkSize, 1), size);
+                if (end < size){
+                    const void* nl = memchr(data + end, '\n', size - end);
+                    end = nl ? static_cast<const char*>(nl) - data + 1 : size;
+                }
+                Chunk* chunk = new Chunk();
+                chunk->data = data + offset;
+                chunk->size = end - offset;
+                chunk->offset = offset;
+                chunks.emplace_back(chunk);
+                offset = end;
+
+                pool.push([chunk, ordered, &callback, &mtx, &condition, &cancelled](){
+                    static thread_local Context context;
+                    try {
+                        if (cancelled.load()){
+                            // an exception is pending, skip the remaining chunks
+                        } else if (ordered){
+                            // collect the records in the chunk's own allocator
+                            chunk->records.SetArray();
+                            rapidjson::Document temp(&chunk->allocator);
+                            chunk->numRecords = readChunk(chunk->data, chunk->size, chunk->offset, chunk->numErrors, temp, [&](rapidjson::Document& doc){
+                                chunk->records.PushBack(doc.Move(), chunk->allocator);
+                            });
+                        } else {
+                            chunk->numRecords = readChunk(chunk->data, chunk->size, chunk->offset, chunk->numErrors, context.document, [&](rapidjson::Document& doc){
+                                callback(ofxJsonValueRef(doc, context.allocator));
+                                doc.SetNull();
+                                context.allocator.Clear();
+                            });
+                        }
+                    } catch (...){
+                        chunk->error = current_exception();
+                        context.document.SetNull();
+                        context.allocator.Clear();
+                    }
+                    lock_guard<mutex> lock(mtx);
+                    chunk->done = true;
+                    condition.notify_one();
+                });
+            }
+            // wait for the oldest chunk
+            Chunk* chunk = chunks.front().get();
+            {
+                unique_lock<mutex> lock(mtx);
+                condition.wait(lock, [chunk](){ return chunk->done; });
+            }
+            if (chunk->error){
+                rethrow_exception(chunk->error);
+            }
+            if (ordered){
+                for (auto it = chunk->records.Begin(); it != chunk->records.End(); ++it){
+                    callback(ofxJsonValueRef(*it, chunk->allocator));
+                }
+            }
+            numRecords_ += chunk->numRecords;
+            numErrors_ += chunk->numErrors;
+            chunks.pop_front();
+        }
+    } catch (...){
+        // the tasks still refer to the chunks and our local variables
+        cancelled.store(true);
+        unique_lock<mutex> lock(mtx);
+        condition.wait(lock, [&chunks](){
+            for (auto& c : chunks){
+                if (!c->done){
+                    return false;
+                }
+            }
+            return true;
+        });
+        throw;
+    }
+    return numRecords_;
+}
+
+/// parse all records of a memory region; returns the number of records
+template<typename Callback>
+inline size_t ofxJsonLinesReader::readChunk(const char* data, size_t size, size_t offset, size_t& numErrors,
+                                            rapidjson::Document& doc, Callback&& callback){
+    rapidjson::MemoryStream ms(data, size);
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(ms);
+    size_t count = 0;
+    for (;;){
+        rapidjson::SkipWhitespace(is);
+        if (is.Peek() == '\0'){
+            return count;
+        }
+        const char* start = ms.src_;
+        doc.ParseStream<rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag>(is);
+        if (!doc.HasParseError()){
+            callback(doc);
+            ++count;
+        } else {
+            ofLogWarning("ofxJsonLinesReader") << rapidjson::GetParseError_En(doc.GetParseError())
+                                               << " [" << (offset + doc.GetErrorOffset()) << "]\n";
+            ++numErrors;
+            // continue after the line where the failed record started
+            // (the parser may have consumed the following lines already)
+            const void* nl = memchr(start, '\n', ms.end_ - start);
+            ms.src_ = nl ? static_cast<const char*>(nl) : ms.end_;
+        }
+    }
+}
+
+inline size_t ofxJsonLinesReader::getNumRecords() const {
+    return numRecords_;
+}
+
+inline size_t ofxJsonLinesReader::getNumErrors() const {
+    return numErrors_;
+}
+
+inline bool ofxJsonLinesReader::readRecord(ofxJsonDocument& record){
+    if (!stream_){
+        return false;
+    }
+    rapidjson::Document& doc = record.document_;
+    for (;;){
+        rapidjson::SkipWhitespace(*stream_);
+        if (stream_->Peek() == '\0'){
+            return false; // end of input
+        }
+        // the previous record isn't needed anymore.
+        // in recycle mode the allocator keeps its chunks for the next record, otherwise they are freed.
+        if (record.recycle_){
+            record.clear();
+        } else {
+            doc.SetNull();
+            doc.GetAllocator().Clear();
+            record.mappedFile_.reset();
+        }
+
+        // keep the record's data, so we can go back to its start on error
+        stream_->mark();
+        doc.ParseStream<rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag>(*stream_);
+        if (!doc.HasParseError()){
+            stream_->unmark();
+            ++numRecords_;
+            return true;
+        }
+        record.printError(doc.GetParseError(), doc.GetErrorOffset());
+        ++numErrors_;
+        // the parser may have consumed the following lines (e.g. a missing closing brace),
+        // so continue after the line where the failed record started
+        stream_->rewind();
+        stream_->unmark();
+        char c;
+        while ((c = stream_->Peek()) != '\n' && c != '\0'){
+            stream_->Take();
+        }
+    }
+}
+
+/*///////////////////// ofxJsonSaxReader /////////////////*/
+
+/// translates rapidjson's Handler concept to the callbacks and takes care of skipping
+struct ofxJsonSaxReader::Handler {
+    ofxJsonSaxReader& r;
+
+    // returns true if the value should be ignored
+    bool skipValue() {
+        if (r.skipDepth_ > 0){
+            return true;
+        }
+        if (r.skipNext_){
+            r.skipNext_ = false;
+            return true;
+        }
+        return false;
+    }
+    bool skipStart() {
+        if (r.skipDepth_ > 0){
+            ++r.skipDepth_;
+            return true;
+        }
+        if (r.skipNext_){
+            r.skipNext_ = false;
+            r.skipDepth_ = 1;
+            return true;
+        }
+        return false;
+    }
+    bool skipEnd() {
+        if (r.skipDepth_ > 0){
+            --r.skipDepth_;
+            return true;
+        }
+        return false;
+    }
+    bool handle(ofxJsonSaxResult result) {
+        if (result == OFX_JSON_SAX_STOP){
+            r.stopped_ = true;
+            return false;
+        }
+        return true;
+    }
+    bool handleStart(ofxJsonSaxResult result) {
+        if (result == OFX_JSON_SAX_SKIP){
+            r.skipDepth_ = 1;
+        } else {
+            ++r.depth_;
+        }
+        return handle(result);
+    }
+    bool integer(int64_t n) {
+        if (skipValue()) return true;
+        if (r.onInt) return handle(r.onInt(n));
+        if (r.onNumber) return handle(r.onNumber(static_cast<double>(n)));
+        return true;
+    }
+
+    bool Null() {
+        if (skipValue() || !r.onNull) return true;
+        return handle(r.onNull());
+    }
+    bool Bool(bool b) {
+        if (skipValue() || !r.onBool) return true;
+        return handle(r.onBool(b));
+    }
+    bool Int(int i) { return integer(i); }
+    bool Uint(unsigned i) { return integer(i); }
+    bool Int64(int64_t i) { return integer(i); }
+    bool Uint64(uint64_t i) {
+        if (i <= static_cast<uint64_t>(numeric_limits<int64_t>::max())){
+            return integer(static_cast<int64_t>(i));
+        }
+        return Double(static_cast<double>(i));
+    }
+    bool Double(double d) {
+        if (skipValue() || !r.onNumber) return true;
+        return handle(r.onNumber(d));
+    }
+    bool RawNumber(const char*, rapidjson::SizeType, bool) {
+        return true; // only used with kParseNumbersAsStringsFlag
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        if (skipValue() || !r.onString) return true;
+        return handle(r.onString(str, length));
+    }
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        if (r.skipDepth_ > 0 || !r.onKey) return true;
+        ofxJsonSaxResult result = r.onKey(str, length);
+        if (result == OFX_JSON_SAX_SKIP){
+            r.skipNext_ = true;
+        }
+        return handle(result);
+    }
+    bool StartObject() {
+        if (skipStart()) return true;
+        return handleStart(r.onStartObject ? r.onStartObject() : OFX_JSON_SAX_CONTINUE);
+    }
+    bool EndObject(rapidjson::SizeType memberCount) {
+        if (skipEnd()) return true;
+        --r.depth_;
+        return r.onEndObject ? handle(r.onEndObject(memberCount)) : true;
+    }
+    bool StartArray() {
+        if (skipStart()) return true;
+        return handleStart(r.onStartArray ? r.onStartArray() : OFX_JSON_SAX_CONTINUE);
+    }
+    bool EndArray(rapidjson::SizeType elementCount) {
+        if (skipEnd()) return true;
+        --r.depth_;
+        return r.onEndArray ? handle(r.onEndArray(elementCount)) : true;
+    }
+};
+
+inline ofxJsonSaxReader::ofxJsonSaxReader()
+    : depth_(0), skipDepth_(0), skipNext_(false), stopped_(false) {}
+
+inline ofxJsonSaxReader::~ofxJsonSaxReader() {}
+
+inline bool ofxJsonSaxReader::parseFile(const string& path, size_t bufferSize){
+    ifstream ifs(path, ios::binary);
+
+    if (!ifs.is_open()){
+        ofLogWarning("ofxJsonSaxReader") << "couldn't open file!\n";
+        return false;
+    }
+
+    return parseStream(ifs, bufferSize);
+}
+
+inline bool ofxJsonSaxReader::parseStream(istream& is, size_t bufferSize){
+    ofxJsonBufferedIStream bis(is, bufferSize);
+    return parse(bis);
+}
+
+inline bool ofxJsonSaxReader::parseBuffer(const string& buffer){
+    return parseBuffer(buffer.data(), buffer.size());
+}
+
+inline bool ofxJsonSaxReader::parseBuffer(const ofBuffer& buffer){
+    return parseBuffer(buffer.getData(), buffer.size());
+}
+
+inline bool ofxJsonSaxReader::parseBuffer(const char* data, size_t size){
+    rapidjson::MemoryStream ms(data, size);
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> is(ms);
+    return parse(is);
+}
+
+inline bool ofxJsonSaxReader::isStopped() const {
+    return stopped_;
+}
+
+inline size_t ofxJsonSaxReader::getDepth() const {
+    return depth_;
+}
+
+template<typename InputStream>
+inline bool ofxJsonSaxReader::parse(InputStream& is){
+    depth_ = 0;
+    skipDepth_ = 0;
+    skipNext_ = false;
+    stopped_ = false;
+
+    Handler handler { *this };
+    rapidjson::ParseResult result = reader_.Parse(is, handler);
+    if (result.IsError() && !stopped_){
+        ofLogWarning("ofxJsonSaxReader") << rapidjson::GetParseError_En(result.Code()) << " [" << result.Offset() << "]\n";
+        return false;
+    } else {
+        return true;
+    }
+}
+
+/*///////////////////// ofxJsonCursor /////////////////*/
+
+/// stores a single event of rapidjson's Handler concept in the cursor
+struct ofxJsonCursor::Handler {
+    ofxJsonCursor& c;
+    bool isKey;
+
+    bool token(ofxJsonTokenType type) {
+        c.type_ = type;
+        return true;
+    }
+    bool Null() { return token(OFX_JSON_TOKEN_NULL); }
+    bool Bool(bool b) { c.bool_ = b; return token(OFX_JSON_TOKEN_BOOL); }
+    bool Int(int i) { return Int64(i); }
+    bool Uint(unsigned i) { return Int64(i); }
+    bool Int64(int64_t i) {
+        c.int_ = i;
+        c.double_ = static_cast<double>(i);
+        c.isInt_ = true;
+        return token(OFX_JSON_TOKEN_NUMBER);
+    }
+    bool Uint64(uint64_t i) {
+        if (i <= static_cast<uint64_t>(numeric_limits<int64_t>::max())){
+            return Int64(static_cast<int64_t>(i));
+        }
+        return Double(static_cast<double>(i));
+    }
+    bool Double(double d) {
+        // converting doubles outside of the int64_t range is undefined behaviour -> clamp
+        if (d >= -9223372036854775808.0 && d < 9223372036854775808.0){
+            c.int_ = static_cast<int64_t>(d);
+        } else if (d > 0){
+            c.int_ = numeric_limits<int64_t>::max();
+        } else if (d < 0){
+            c.int_ = numeric_limits<int64_t>::min();
+        } else {
+            c.int_ = 0; // NaN
+        }
+        c.double_ = d;
+        c.isInt_ = false;
+        return token(OFX_JSON_TOKEN_NUMBER);
+    }
+    bool RawNumber(const char*, rapidjson::SizeType, bool) {
+        return true; // only used with kParseNumbersAsStringsFlag
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool) {
+        c.string_ = str;
+        c.length_ = length;
+        return token(OFX_JSON_TOKEN_STRING);
+    }
+    bool Key(const char* str, rapidjson::SizeType length, bool) {
+        // the key string is overwritten while parsing the value, so we have to copy it
+        c.key_.assign(str, length);
+        isKey = true;
+        return true;
+    }
+    bool StartObject() { return token(OFX_JSON_TOKEN_START_OBJECT); }
+    bool EndObject(rapidjson::SizeType) { return token(OFX_JSON_TOKEN_END_OBJECT); }
+    bool StartArray() { return token(OFX_JSON_TOKEN_START_ARRAY); }
+    bool EndArray(rapidjson::SizeType) { return token(OFX_JSON_TOKEN_END_ARRAY); }
+};
 
-template<typename T>
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::operator<<(T&& val){
-    doAdd(forward<T>(val));
-    return *this;
+inline ofxJsonCursor::ofxJsonCursor(){
+    close();
 }
 
-inline void ofxPrettyJsonWriter::reset(){
-    buffer_.Clear();
-    writer_.Reset(buffer_);
-}
+inline ofxJsonCursor::~ofxJsonCursor() {}
 
-inline bool ofxPrettyJsonWriter::saveToBuffer(string& buffer){
-    if (writer_.IsComplete()){
-        buffer.assign(buffer_.GetString(), buffer_.GetSize());
+inline bool ofxJsonCursor::openFile(const string& path, size_t bufferSize){
+    close();
+    unique_ptr<ofxJsonMappedFile> file(new ofxJsonMappedFile());
+    if (file->open(path)){
+        openBuffer(file->getData(), file->size());
+        file_ = std::move(file);
         return true;
-    } else {
-        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+    }
+    // can't be mapped -> read in blocks
+    unique_ptr<ifstream> ifs(new ifstream(path, ios::binary));
+    if (!ifs->is_open()){
+        ofLogWarning("ofxJsonCursor") << "couldn't open file!\n";
         return false;
     }
+    openStream(*ifs, bufferSize);
+    ifstream_ = std::move(ifs);
+    return true;
 }
 
-inline bool ofxPrettyJsonWriter::saveToBuffer(ofBuffer& buffer){
-    if (writer_.IsComplete()){
-        buffer.set(buffer_.GetString(), buffer_.GetSize());
-        return true;
+inline bool ofxJsonCursor::openStream(istream& is, size_t bufferSize){
+    close();
+    stream_.reset(new ofxJsonBufferedIStream(is, bufferSize));
+    return true;
+}
+
+inline bool ofxJsonCursor::openBuffer(const char* data, size_t size){
+    close();
+    memory_.reset(new rapidjson::MemoryStream(data, size));
+    memoryStream_.reset(new MemoryInputStream(*memory_));
+    return true;
+}
+
+inline bool ofxJsonCursor::openBuffer(const string& buffer){
+    return openBuffer(buffer.data(), buffer.size());
+}
+
+inline bool ofxJsonCursor::openBuffer(const ofBuffer& buffer){
+    return openBuffer(buffer.getData(), buffer.size());
+}
+
+inline void ofxJsonCursor::close(){
+    memoryStream_.reset();
+    memory_.reset();
+    stream_.reset();
+    ifstream_.reset();
+    file_.reset();
+    reader_.IterativeParseInit();
+    type_ = OFX_JSON_TOKEN_NONE;
+    depth_ = 0;
+    key_.clear();
+    hasKey_ = false;
+    string_ = nullptr;
+    length_ = 0;
+    int_ = 0;
+    double_ = 0;
+    isInt_ = false;
+    bool_ = false;
+    error_ = false;
+}
+
+inline bool ofxJsonCursor::next(){
+    if (error_ || reader_.IterativeParseComplete()){
+        type_ = OFX_JSON_TOKEN_NONE;
+        return false;
+    }
+    // the depth changes *after* a start token and *before* an end token
+    if (type_ == OFX_JSON_TOKEN_START_OBJECT || type_ == OFX_JSON_TOKEN_START_ARRAY){
+        ++depth_;
+    }
+    bool result;
+    if (memoryStream_){
+        result = parseNext(*memoryStream_);
+    } else if (stream_){
+        result = parseNext(*stream_);
     } else {
-        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
+        result = false;
+    }
+    if (!result){
+        type_ = OFX_JSON_TOKEN_NONE;
         return false;
     }
+    if (type_ == OFX_JSON_TOKEN_END_OBJECT || type_ == OFX_JSON_TOKEN_END_ARRAY){
+        --depth_;
+    }
+    return true;
+}
+
+template<typename InputStream>
+inline bool ofxJsonCursor::parseNext(InputStream& is){
+    Handler handler { *this, false };
+    // a key is followed by its value, so we need (at most) two steps.
+    for (int i = 0; i < 2; ++i){
+        if (!reader_.IterativeParseNext<rapidjson::kParseDefaultFlags>(is, handler)){
+            error_ = true;
+            ofLogWarning("ofxJsonCursor") << rapidjson::GetParseError_En(reader_.GetParseErrorCode())
+                                          << " [" << reader_.GetErrorOffset() << "]\n";
+            return false;
+        }
+        if (!handler.isKey){
+            break;
+        }
+    }
+    // end tokens don't belong to a member
+    hasKey_ = handler.isKey;
+    return true;
 }
 
-inline bool ofxPrettyJsonWriter::saveToFile(const string& path){
-    if (writer_.IsComplete()){
-        ofstream ofs(path);
-
-        if (!ofs.is_open()){
-            ofLogWarning("ofxPrettyJsonWriter") << "couldn't open file!\n";
-            return false;
-        } else {
-            ofs.write(buffer_.GetString(), buffer_.GetSize());
+inline bool ofxJsonCursor::skip(){
+    size_t depth;
+    if (type_ == OFX_JSON_TOKEN_START_OBJECT || type_ == OFX_JSON_TOKEN_START_ARRAY){
+        depth = depth_;
+    } else if (depth_ > 0){
+        depth = depth_ - 1;
+    } else {
+        return next(); // root scalar
+    }
+    while (next()){
+        if ((type_ == OFX_JSON_TOKEN_END_OBJECT || type_ == OFX_JSON_TOKEN_END_ARRAY) && depth_ == depth){
             return true;
         }
-    } else {
-        ofLogWarning("ofxPrettyJsonWriter") << "JSON is not complete!\n";
-        return false;
     }
+    return false;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::startObject(){
-    writer_.StartObject(); return *this;
+inline bool ofxJsonCursor::hasError() const {
+    return error_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::endObject(){
-    writer_.EndObject(); return *this;
+inline ofxJsonTokenType ofxJsonCursor::getType() const {
+    return type_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::startArray(){
-    writer_.StartArray(); return *this;
+inline size_t ofxJsonCursor::getDepth() const {
+    return depth_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::endArray(){
-    writer_.EndArray(); return *this;
+inline bool ofxJsonCursor::hasKey() const {
+    return hasKey_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addKey(const string& s){
-    writer_.Key(s.data(), s.size(), true); return *this;
+inline const string& ofxJsonCursor::getKey() const {
+    return key_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addString(const string& s){
-    writer_.String(s.data(), s.size(), true); return *this;
+inline const char* ofxJsonCursor::getStringData() const {
+    return string_;
 }
 
-template<typename T>
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addNumber(T n){
-    doAdd(n); return *this;
+inline size_t ofxJsonCursor::getStringLength() const {
+    return length_;
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addNull(){
-    writer_.Null(); return *this;
+inline string ofxJsonCursor::getString() const {
+    return type_ == OFX_JSON_TOKEN_STRING ? string(string_, length_) : string();
 }
 
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addBool(bool b){
-    writer_.Bool(b); return *this;
+inline bool ofxJsonCursor::getBool() const {
+    return bool_;
 }
 
+inline bool ofxJsonCursor::isInt() const {
+    return isInt_;
+}
 
-template<typename T>
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addArray(const vector<T>& vec){
-    doAdd(vec);
-    return *this;
+inline int64_t ofxJsonCursor::getInt() const {
+    return int_;
 }
 
-template<typename T>
-inline ofxPrettyJsonWriter& ofxPrettyJsonWriter::addObject(const unordered_map<string, T>& map){
-    doAdd(map);
-    return *this;
+inline double ofxJsonCursor::getDouble() const {
+    return double_;
 }
 
-inline void ofxPrettyJsonWriter::doAdd(uint32_t n){writer_.Uint(n);}
-inline void ofxPrettyJsonWriter::doAdd(int32_t n){writer_.Int(n);}
-inline void ofxPrettyJsonWriter::doAdd(uint64_t n){writer_.Uint64(n);}
-inline void ofxPrettyJsonWriter::doAdd(int64_t n){writer_.Int64(n);}
-inline void ofxPrettyJsonWriter::doAdd(float n){writer_.Double(n);}
-inline void ofxPrettyJsonWriter::doAdd(double n){writer_.Double(n);}
-inline void ofxPrettyJsonWriter::doAdd(const string& s){writer_.String(s.data(), s.size(), true);}
-template<int N>
-inline void ofxPrettyJsonWriter::doAdd(const char(&s)[N]){writer_.String(s, N-1, true);}
-inline void ofxPrettyJsonWriter::doAdd(bool b){writer_.Bool(b);}
-template<typename T>
-inline void ofxPrettyJsonWriter::doAdd(const vector<T>& vec){
-    writer_.StartArray();
-    for (auto& k : vec){
-        doAdd(k);
+/*///////////////////// ofxJsonLazyDocument /////////////////*/
+
+inline ofxJsonLazyDocument::ofxJsonLazyDocument()
+    : scratch_(&document_.document_.GetAllocator()), data_(nullptr), size_(0), numPending_(0), error_(false) {}
+
+inline ofxJsonLazyDocument::~ofxJsonLazyDocument() {}
+
+inline bool ofxJsonLazyDocument::loadFromFile(const string& path){
+    clear();
+    unique_ptr<ofxJsonMappedFile> file(new ofxJsonMappedFile());
+    if (file->open(path)){
+        data_ = file->getData();
+        size_ = file->size();
+        file_ = std::move(file);
+    } else {
+        // can't be mapped -> read into memory
+        ifstream ifs(path, ios::binary);
+        if (!ifs.is_open()){
+            ofLogWarning("ofxJsonLazyDocument") << "couldn't open file!\n";
+            return false;
+        }
+        stringstream ss;
+        ss << ifs.rdbuf();
+        buffer_ = ss.str();
+        data_ = buffer_.data();
+        size_ = buffer_.size();
     }
-    writer_.EndArray();
+    if (!index()){
+        clear();
+        return false;
+    }
+    return true;
 }
-template<typename T>
-inline void ofxPrettyJsonWriter::doAdd(const unordered_map<string, T>& map){
-    writer_.StartObject();
-    for (auto& e : map){
-        addKey(e.first);
-        doAdd(e.second);
+
+inline bool ofxJsonLazyDocument::loadFromBuffer(const string& buffer){
+    clear();
+    buffer_ = buffer;
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    if (!index()){
+        clear();
+        return false;
     }
-    writer_.EndObject();
+    return true;
 }
 
-/*///////////// ofxJsonDocument ////////////////////*/
+inline bool ofxJsonLazyDocument::loadFromBuffer(const ofBuffer& buffer){
+    return loadFromBuffer(string(buffer.getData(), buffer.size()));
+}
 
-/// constructors
-inline ofxJsonDocument::ofxJsonDocument()
-    : document_() {}
+// the save methods never write a document with errors (the broken parts would be saved as null)
+inline bool ofxJsonLazyDocument::saveToFile(const string& path, bool pretty, bool atomic){
+    return buildAll() && document_.saveToFile(path, pretty, atomic);
+}
 
-inline ofxJsonDocument::ofxJsonDocument(const ofxJsonDocument& mom)
-    : document_() {
-    document_.CopyFrom(mom.document_, document_.GetAllocator());
+inline ofxJsonSaveHandle ofxJsonLazyDocument::saveToFileAsync(const string& path, bool pretty, bool atomic, ofxJsonThreadPool& pool){
+    return buildAll() ? document_.saveToFileAsync(path, pretty, atomic, pool) : ofxJsonSaveHandle();
 }
 
-inline ofxJsonDocument::ofxJsonDocument(ofxJsonDocument&& mom)
-    : document_(std::move(mom.document_)) {}
+inline bool ofxJsonLazyDocument::saveToBuffer(string& buffer, bool pretty){
+    return buildAll() && document_.saveToBuffer(buffer, pretty);
+}
 
-inline ofxJsonDocument::~ofxJsonDocument() {}
+inline bool ofxJsonLazyDocument::saveToBuffer(ofBuffer& buffer, bool pretty){
+    return buildAll() && document_.saveToBuffer(buffer, pretty);
+}
 
-/// assignment
-inline ofxJsonDocument& ofxJsonDocument::operator =(const ofxJsonDocument& mom){
-    if (this != &mom){
-        document_.CopyFrom(mom.document_, document_.GetAllocator());
+inline bool ofxJsonLazyDocument::saveToBuffer(char* data, size_t capacity, size_t& size, bool pretty){
+    if (!buildAll()){
+        size = 0;
+        return false;
     }
-    return *this;
+    return document_.saveToBuffer(data, capacity, size, pretty);
 }
 
-inline ofxJsonDocument& ofxJsonDocument::operator =(ofxJsonDocument&& mom){
-    if (this != &mom){
-        document_ = std::move(mom.document_);
-    }
+inline bool ofxJsonLazyDocument::saveToBuffer(ofxJsonSegmentedOStream& buffer, bool pretty){
+    return buildAll() && document_.saveToBuffer(buffer, pretty);
+}
 
-    return *this;
+inline size_t ofxJsonLazyDocument::serializedSize(bool pretty){
+    return buildAll() ? document_.serializedSize(pretty) : 0;
 }
 
-/// loading JSON data
-inline bool ofxJsonDocument::loadFromFile(const string& path){
-    ifstream ifs(path);
+inline ofxJsonBufferView ofxJsonLazyDocument::saveToView(bool pretty){
+    return buildAll() ? document_.saveToView(pretty) : ofxJsonBufferView();
+}
 
-    if (!ifs.is_open()){
-        ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
-        return false;
-    }
+inline void ofxJsonLazyDocument::setMaxDecimalPlaces(int places){
+    document_.setMaxDecimalPlaces(places);
+}
 
-    rapidjson::IStreamWrapper isw(ifs);
-    document_.ParseStream(isw);
-    if (document_.HasParseError()){
-        printError(document_.GetParseError(), document_.GetErrorOffset());
-        return false;
-    } else {
-        return true;
-    }
+inline int ofxJsonLazyDocument::getMaxDecimalPlaces() const {
+    return document_.getMaxDecimalPlaces();
 }
 
-inline bool ofxJsonDocument::loadFromBuffer(const char *data, size_t size){
-    document_.Parse(data, size);
-    if (document_.HasParseError()){
-        printError(document_.GetParseError(), document_.GetErrorOffset());
-        return false;
+inline void ofxJsonLazyDocument::clear(){
+    document_.document_.SetNull();
+    document_.document_.GetAllocator().Clear();
+    containers_.clear();
+    numPending_ = 0;
+    error_ = false;
+    file_.reset();
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+inline ofxJsonValueIterator ofxJsonLazyDocument::find(const string& key){
+    rapidjson::Pointer ptr(key.data(), key.size());
+    return ofxJsonValueIterator(resolve(ptr), document_.document_.GetAllocator());
+}
+
+inline ofxJsonValueRef ofxJsonLazyDocument::operator[](const string& key){
+    rapidjson::Pointer ptr(key.data(), key.size());
+    rapidjson::Value* value = resolve(ptr);
+    if (value){
+        return ofxJsonValueRef(*value, document_.document_.GetAllocator());
     } else {
-        return true;
+        // all containers on the path have been built by resolve()
+        return ofxJsonValueRef(ptr.Create(document_.document_), document_.document_.GetAllocator());
     }
 }
 
-inline bool ofxJsonDocument::loadFromBuffer(const string& buffer){
-    return loadFromBuffer(buffer.data(), buffer.size());
+inline ofxJsonValueIterator ofxJsonLazyDocument::end(){
+    return ofxJsonValueIterator(nullptr, document_.document_.GetAllocator());
 }
 
-inline bool ofxJsonDocument::loadFromBuffer(const ofBuffer& buffer){
-    return loadFromBuffer(buffer.getData(), buffer.size());
+inline ofxJsonValueRef ofxJsonLazyDocument::getRoot(){
+    buildAll();
+    return document_.getRoot();
 }
 
-/// saving JSON data
-inline bool ofxJsonDocument::saveToFile(const string& path, bool pretty){
-    ofstream ofs(path);
+inline rapidjson::Document& ofxJsonLazyDocument::getDocument(){
+    buildAll();
+    return document_.getDocument();
+}
 
-    if (!ofs.is_open()){
-        ofLogWarning("ofxJsonDocument") << "couldn't open file!\n";
-        return false;
-    }
+inline bool ofxJsonLazyDocument::hasError() const {
+    return error_;
+}
 
-    rapidjson::OStreamWrapper osw(ofs);
+inline size_t ofxJsonLazyDocument::getSourceSize() const {
+    return size_;
+}
 
-    if (pretty){
-        rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
-        return (document_.Accept(writer));
-    } else {
-        rapidjson::Writer<rapidjson::OStreamWrapper> writer(osw);
-        return (document_.Accept(writer));
+inline size_t ofxJsonLazyDocument::getNumPending() const {
+    return numPending_;
+}
+
+inline bool ofxJsonLazyDocument::isPending(const rapidjson::Value& value) const {
+    if (!value.IsString()){
+        return false;
+    }
+    uintptr_t p = reinterpret_cast<uintptr_t>(value.GetString());
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data_);
+    return p >= begin && p < begin + size_;
+}
+
+/// NOTE: index() makes sure that the container fits into a string (< 4 GB)
+inline void ofxJsonLazyDocument::makePending(rapidjson::Value& value, size_t begin, size_t end){
+    value.SetString(rapidjson::StringRef(data_ + begin, static_cast<rapidjson::SizeType>(end - begin + 1)));
+    numPending_++;
+}
+
+inline bool ofxJsonLazyDocument::buildShallow(rapidjson::Value& value){
+    size_t begin = value.GetString() - data_;
+    size_t end = begin + value.GetStringLength() - 1; // closing bracket
+    bool isObject = data_[begin] == '{';
+    auto& allocator = document_.document_.GetAllocator();
+    rapidjson::Value container(isObject ? rapidjson::kObjectType : rapidjson::kArrayType);
+    numPending_--;
+
+    size_t pos = skipWhitespace(begin + 1);
+    while (pos < end){
+        rapidjson::Value key;
+        if (isObject){
+            if (data_[pos] != '"'){
+                printError(rapidjson::kParseErrorObjectMissName, pos);
+                value.SetNull();
+                return false;
+            }
+            size_t keyEnd = findStringEnd(pos);
+            if (!parseString(key, pos, keyEnd)){
+                value.SetNull();
+                return false;
+            }
+            pos = skipWhitespace(keyEnd + 1);
+            if (data_[pos] != ':'){
+                printError(rapidjson::kParseErrorObjectMissColon, pos);
+                value.SetNull();
+                return false;
+            }
+            pos = skipWhitespace(pos + 1);
+        }
+        rapidjson::Value element;
+        char c = data_[pos];
+        if (c == '{' || c == '['){
+            // skip nested containers with the help of the index
+            size_t containerEnd = findContainerEnd(pos);
+            makePending(element, pos, containerEnd);
+            pos = containerEnd + 1;
+        } else if (c == '"'){
+            size_t stringEnd = findStringEnd(pos);
+            if (!parseString(element, pos, stringEnd)){
+                value.SetNull();
+                return false;
+            }
+            pos = stringEnd + 1;
+        } else {
+            size_t scalarEnd = pos;
+            while (scalarEnd < end){
+                char ch = data_[scalarEnd];
+                if (ch == ',' || ch == ']' || ch == '}' || ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t'){
+                    break;
+                }
+                scalarEnd++;
+            }
+            if (scalarEnd == pos){
+                printError(rapidjson::kParseErrorValueInvalid, pos);
+                value.SetNull();
+                return false;
+            }
+            if (!parseRange(element, pos, scalarEnd)){
+                value.SetNull();
+                return false;
+            }
+            pos = scalarEnd;
+        }
+        if (isObject){
+            container.AddMember(key, element, allocator);
+        } else {
+            container.PushBack(element, allocator);
+        }
+        pos = skipWhitespace(pos);
+        if (pos < end && data_[pos] == ','){
+            pos = skipWhitespace(pos + 1);
+            if (pos == end){
+                printError(rapidjson::kParseErrorValueInvalid, pos);
+                value.SetNull();
+                return false;
+            }
+        } else if (pos != end){
+            printError(isObject ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket
+                                : rapidjson::kParseErrorArrayMissCommaOrSquareBracket, pos);
+            value.SetNull();
+            return false;
+        }
     }
+    value = container;
+    return true;
 }
 
-/// save to binary buffer
+inline bool ofxJsonLazyDocument::buildDeep(rapidjson::Value& value){
+    if (!numPending_){
+        return true;
+    }
+    if (isPending(value)){
+        size_t begin = value.GetString() - data_;
+        size_t end = begin + value.GetStringLength();
+        numPending_--;
+        return parseRange(value, begin, end);
+    }
+    bool result = true;
+    if (value.IsObject()){
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it){
+            result &= buildDeep(it->value);
+        }
+    } else if (value.IsArray()){
+        for (auto it = value.Begin(); it != value.End(); ++it){
+            result &= buildDeep(*it);
+        }
+    }
+    return result;
+}
 
-inline bool ofxJsonDocument::saveToBuffer(rapidjson::StringBuffer& buf, bool pretty){
-    if (pretty){
-        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buf);
-        return document_.Accept(writer);
+inline bool ofxJsonLazyDocument::buildAll(){
+    if (!buildDeep(document_.document_)){
+        error_ = true; // sticky: the broken parts are null now and won't be built again
+    }
+    if (error_){
+        ofLogWarning("ofxJsonLazyDocument") << "document has errors!\n";
+    }
+    return !error_;
+}
+
+/// parse [begin, end) as a single value
+inline bool ofxJsonLazyDocument::parseRange(rapidjson::Value& value, size_t begin, size_t end){
+    size_t size = end - begin;
+    const char* data = data_ + begin;
+    // the literals are common enough to skip the reader
+    if (size == 4 && !memcmp(data, "null", 4)){
+        value.SetNull();
+    } else if (size == 4 && !memcmp(data, "true", 4)){
+        value.SetBool(true);
+    } else if (size == 5 && !memcmp(data, "false", 5)){
+        value.SetBool(false);
     } else {
-        rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
-        return document_.Accept(writer);
+        scratch_.Parse(data, size);
+        if (scratch_.HasParseError()){
+            printError(scratch_.GetParseError(), begin + scratch_.GetErrorOffset());
+            value.SetNull();
+            return false;
+        }
+        value = static_cast<rapidjson::Value&>(scratch_);
     }
+    return true;
 }
 
-inline bool ofxJsonDocument::saveToBuffer(string& buffer, bool pretty){
-    rapidjson::StringBuffer stringBuf;
-    if (saveToBuffer(stringBuf, pretty)){
-        buffer.assign(stringBuf.GetString(), stringBuf.GetSize());
-        return true;
-    } else {
+/// parse the string between the quotes at 'begin' and 'end'
+inline bool ofxJsonLazyDocument::parseString(rapidjson::Value& value, size_t begin, size_t end){
+    if (end >= size_){
+        printError(rapidjson::kParseErrorStringMissQuotationMark, begin);
         return false;
     }
+    const char* str = data_ + begin + 1;
+    size_t length = end - begin - 1;
+    if (memchr(str, '\\', length)){
+        return parseRange(value, begin, end + 1); // unescape
+    } else {
+        value.SetString(str, static_cast<rapidjson::SizeType>(length), document_.document_.GetAllocator());
+        return true;
+    }
 }
 
-inline bool ofxJsonDocument::saveToBuffer(ofBuffer& buffer, bool pretty){
-    rapidjson::StringBuffer stringBuf;
-    if (saveToBuffer(stringBuf, pretty)){
-        buffer.set(stringBuf.GetString(), stringBuf.GetSize());
+inline rapidjson::Value* ofxJsonLazyDocument::resolve(const rapidjson::Pointer& ptr){
+    if (!ptr.IsValid()){
+        return nullptr;
+    }
+    rapidjson::Value* value = &document_.document_;
+    const rapidjson::Pointer::Token* tokens = ptr.GetTokens();
+    for (size_t i = 0; i < ptr.GetTokenCount(); ++i){
+        if (isPending(*value) && !buildShallow(*value)){
+            error_ = true;
+            return nullptr;
+        }
+        const rapidjson::Pointer::Token& token = tokens[i];
+        if (value->IsObject()){
+            rapidjson::Value name(rapidjson::StringRef(token.name, token.length));
+            auto it = value->FindMember(name);
+            if (it == value->MemberEnd()){
+                return nullptr;
+            }
+            value = &it->value;
+        } else if (value->IsArray()){
+            if (token.index == rapidjson::kPointerInvalidIndex || token.index >= value->Size()){
+                return nullptr;
+            }
+            value = &(*value)[token.index];
+        } else {
+            return nullptr;
+        }
+    }
+    if (!buildDeep(*value)){
+        error_ = true;
+    }
+    return value;
+}
+
+/// the structural pass: find all containers (outside of strings) and their closing brackets
+inline bool ofxJsonLazyDocument::index(){
+    vector<size_t> stack;
+    rapidjson::ParseErrorCode error = rapidjson::kParseErrorNone;
+    size_t errorOffset = 0;
+    ofxJsonStructuralIndex structuralIndex;
+    bool result = structuralIndex.scan(data_, size_, [&](size_t pos){
+        char c = data_[pos];
+        if (c == '{' || c == '['){
+            stack.push_back(containers_.size());
+            containers_.emplace_back(pos, 0);
+        } else if (c == '}' || c == ']'){
+            bool isObject = c == '}';
+            if (stack.empty() || data_[containers_[stack.back()].first] != (isObject ? '{' : '[')){
+                error = isObject ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket
+                                 : rapidjson::kParseErrorArrayMissCommaOrSquareBracket;
+                errorOffset = pos;
+                return false;
+            }
+            auto& container = containers_[stack.back()];
+            // pending containers are stored as strings (see makePending())
+            if (pos - container.first >= numeric_limits<rapidjson::SizeType>::max()){
+                ofLogWarning("ofxJsonLazyDocument") << "containers larger than 4 GB are not supported!\n";
+                return false;
+            }
+            container.second = pos;
+            stack.pop_back();
+        }
         return true;
-    } else {
+    });
+    if (!result){
+        if (error != rapidjson::kParseErrorNone){
+            printError(error, errorOffset);
+        } else if (structuralIndex.getError() != rapidjson::kParseErrorTermination){
+            printError(structuralIndex.getError(), structuralIndex.getErrorOffset());
+        }
+        return false;
+    }
+    if (!stack.empty()){
+        bool isObject = data_[containers_[stack.back()].first] == '{';
+        printError(isObject ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket
+                            : rapidjson::kParseErrorArrayMissCommaOrSquareBracket, size_);
         return false;
     }
-}
-
-inline void ofxJsonDocument::clear(){
-    document_.Clear();
-}
 
-/// find value by key
-inline ofxJsonValueIterator ofxJsonDocument::find(const string& key){
-    rapidjson::Pointer ptr(key.data(), key.size());
-    return ofxJsonValueIterator(ptr.Get(document_), document_.GetAllocator());
+    rapidjson::Value& root = document_.document_;
+    size_t begin = skipWhitespace(0);
+    if (begin == size_){
+        printError(rapidjson::kParseErrorDocumentEmpty, begin);
+        return false;
+    }
+    if (containers_.empty() || containers_[0].first != begin){
+        // scalar root: just parse it
+        return parseRange(root, 0, size_);
+    }
+    size_t end = containers_[0].second;
+    size_t trailing = skipWhitespace(end + 1);
+    if (trailing != size_){
+        printError(rapidjson::kParseErrorDocumentRootNotSingular, trailing);
+        return false;
+    }
+    makePending(root, begin, end);
+    return true;
 }
 
-/// find value by key
-inline ofxJsonValueIterator ofxJsonDocument::end(){
-    return ofxJsonValueIterator(nullptr, document_.GetAllocator());
+inline size_t ofxJsonLazyDocument::findContainerEnd(size_t begin) const {
+    auto it = lower_bound(containers_.begin(), containers_.end(), make_pair(begin, size_t(0)));
+    return it->second; // always found because begin comes from the structural pass
 }
 
-inline ofxJsonValueRef ofxJsonDocument::operator[](const string& key) {
-    rapidjson::Pointer ptr(key.data(), key.size());
-    rapidjson::Value* value = ptr.Get(document_);
-    if (value){
-        return ofxJsonValueRef(*value, document_.GetAllocator());
-    } else {
-        return ofxJsonValueRef(ptr.Create(document_), document_.GetAllocator());
+/// returns the offset of the closing quote (or size_ if there is none)
+inline size_t ofxJsonLazyDocument::findStringEnd(size_t begin) const {
+    size_t pos = begin + 1;
+    while (pos < size_){
+        char c = data_[pos];
+        if (c == '"'){
+            return pos;
+        } else if (c == '\\'){
+            pos += 2;
+        } else {
+            pos++;
+        }
     }
+    return size_;
 }
 
-/// get root value reference
-inline ofxJsonValueRef ofxJsonDocument::getRoot(){
-    return ofxJsonValueRef(document_, document_.GetAllocator());
-}
-
-/// get document
-inline rapidjson::Document& ofxJsonDocument::getDocument(){
-    return document_;
+inline size_t ofxJsonLazyDocument::skipWhitespace(size_t pos) const {
+    while (pos < size_){
+        char c = data_[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t'){
+            break;
+        }
+        pos++;
+    }
+    return pos;
 }
 
-/// print parse error
-inline void ofxJsonDocument::printError(rapidjson::ParseErrorCode error, size_t offset){
-    ofLogWarning("ofxJsonDocument") << rapidjson::GetParseError_En(error) << " [" << offset << "]\n";
+inline void ofxJsonLazyDocument::printError(rapidjson::ParseErrorCode error, size_t offset){
+    ofLogWarning("ofxJsonLazyDocument") << rapidjson::GetParseError_En(error) << " [" << offset << "]\n";
 }
 
-
 /*///////////////////// ofxJsonValueRef /////////////////*/
 
 /// constructors:
@@ -480,6 +3791,10 @@ inline bool ofxJsonValueRef::isObject() const{
     return value_.IsObject();
 }
 
+inline size_t ofxJsonValueRef::getFootprint() const {
+    return value_.GetFootprint();
+}
+
 inline bool ofxJsonValueRef::operator==(const ofxJsonValueRef& other){
     return (&value_ == &other.value_); // compare addresses!
 }